@@ -0,0 +1,139 @@
+#include <iostream>
+
+//configuration
+#define ASCS_SERVER_PORT	9527
+#define ASCS_COROUTINE //needs c++20
+#define ASCS_MAX_SEND_BUF	(64 * 1024)
+#define ASCS_MAX_RECV_BUF	(64 * 1024) //much smaller than the amount of msgs, so async_safe_send must wait for the sending buffer again and again
+//configuration
+
+#include <ascs/ext/tcp.h>
+using namespace ascs;
+using namespace ascs::ext;
+
+#define MSG_LEN		100
+#define BURST_NUM	1000 //MSG_LEN * BURST_NUM is bigger than ASCS_MAX_SEND_BUF
+
+std::atomic_size_t echoed_num(0), received_num(0), error_num(0), finished_num(0), waiting_num(0);
+
+std::string make_msg(size_t seq) {auto msg = std::to_string(seq); msg.resize(MSG_LEN, ' '); return msg;}
+
+//server sockets echo msgs back in a coroutine rather than on_msg_handle, the coroutine awaits the last msg of each batch been sent, so
+// msgs are kept in the receiving buffer in the meantime, and message receiving will be suspended after it been full (backpressure).
+class echo_socket : public ascs::ext::tcp::server_socket
+{
+public:
+	echo_socket(ascs::tcp::i_server& server_) : ascs::ext::tcp::server_socket(server_) {}
+
+protected:
+	virtual void on_connect() {echo();}
+
+private:
+	co_flow echo()
+	{
+		for (;;)
+		{
+			auto msgs = co_await async_recv_batch();
+			if (msgs.empty())
+				break; //closed, this socket may be reused or freed, don't touch it any more
+
+			auto num = msgs.size();
+			for (auto iter = std::begin(msgs); std::next(iter) != std::end(msgs); ++iter)
+				send_msg(iter->data(), iter->size(), true); //the batch is limited by the receiving buffer
+
+			if (sync_call_result::SUCCESS == co_await async_send(msgs.back().data(), msgs.back().size())) //msgs stay in this frame until being sent
+				echoed_num += num;
+			else
+				++error_num;
+		}
+	}
+};
+
+//each client runs two coroutines, one sends msg_num msgs (with sequence numbers) in bursts, the other one receives and checks them.
+co_flow send_msgs(std::shared_ptr<ascs::ext::tcp::client_socket> client, size_t msg_num)
+{
+	if (!co_await client->async_connect())
+	{
+		++error_num;
+		++finished_num;
+		co_return;
+	}
+
+	//the awaitable owns a copy of the msg, so it can be created before being awaited.
+	auto first = client->async_send(make_msg(0));
+	if (sync_call_result::SUCCESS != co_await first)
+		++error_num;
+
+	for (size_t i = 1; i < msg_num; ++i)
+		if (0 != i % BURST_NUM)
+			client->send_msg(make_msg(i), true);
+		else
+		{
+			//the burst overflowed the sending buffer, async_safe_send suspends this coroutine until the buffer has room.
+			if (!client->is_send_buffer_available())
+				++waiting_num;
+			if (sync_call_result::SUCCESS != co_await client->async_safe_send(make_msg(i)))
+			{
+				++error_num;
+				break;
+			}
+
+			co_await client->async_wait(1); //just to show how to pause a flow without blocking any threads
+		}
+}
+
+co_flow recv_msgs(std::shared_ptr<ascs::ext::tcp::client_socket> client, size_t msg_num)
+{
+	size_t next_seq = 0;
+	for (;;)
+	{
+		auto msgs = co_await client->async_recv_batch();
+		if (msgs.empty())
+			break;
+
+		for (auto& msg : msgs)
+			if (make_msg(next_seq++) != std::string(msg.data(), msg.size()))
+				++error_num;
+
+		received_num += msgs.size();
+		if (next_seq == msg_num)
+			++finished_num;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	printf("usage: %s [<client number=16> [<msg number per client=10000>]]\n", argv[0]);
+
+	size_t client_num = 16, msg_num = 10000;
+	if (argc > 1)
+		client_num = std::max((size_t) atoi(argv[1]), (size_t) 1);
+	if (argc > 2)
+		msg_num = std::max((size_t) atoi(argv[2]), (size_t) 1);
+
+	service_pump sp;
+	ascs::tcp::server_base<echo_socket> server(sp);
+	ascs::tcp::multi_client_base<ascs::ext::tcp::client_socket> client(sp);
+	std::vector<std::shared_ptr<ascs::ext::tcp::client_socket>> clients;
+	for (size_t i = 0; i < client_num; ++i)
+		clients.push_back(client.add_socket());
+
+	sp.start_service(2);
+	auto begin_time = std::chrono::system_clock::now();
+	for (auto& item : clients)
+	{
+		recv_msgs(item, msg_num);
+		send_msgs(item, msg_num);
+	}
+
+	while (finished_num < client_num && std::chrono::system_clock::now() - begin_time < std::chrono::seconds(60))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	auto used_time = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::system_clock::now() - begin_time).count();
+
+	printf(ASCS_SF " of " ASCS_SF " clients finished, " ASCS_SF " msgs echoed, " ASCS_SF " of " ASCS_SF " msgs received, " ASCS_SF " error(s), "
+		ASCS_SF " time(s) waited for the sending buffer, %.3f seconds.\n",
+		finished_num.load(), client_num, echoed_num.load(), received_num.load(), client_num * msg_num, error_num.load(), waiting_num.load(), used_time);
+	sp.stop_service();
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+
+//configuration
+#define ASCS_SERVER_PORT	9527
+#define ASCS_CREDIT_FLOW_CONTROL
+#define ASCS_MAX_SEND_BUF	(64 * 1024)
+#define ASCS_MAX_RECV_BUF	(64 * 1024) //much smaller than the amount of msgs, so credits must be granted again and again
+//configuration
+
+#include <ascs/ext/tcp.h>
+using namespace ascs;
+using namespace ascs::ext;
+
+#define MSG_LEN	1024 //fixed_length_unpacker's default length
+
+std::atomic_size_t received_num(0), error_num(0);
+
+//non-default packers and unpackers need some settings
+template<typename Packer> void setup_packer(Packer& p) {}
+void setup_packer(prefix_suffix_packer& p) {p.prefix_suffix("begin", "end");}
+template<typename Unpacker> void setup_unpacker(Unpacker& u) {}
+void setup_unpacker(prefix_suffix_unpacker& u) {u.prefix_suffix("begin", "end");}
+void setup_unpacker(fixed_length_unpacker& u) {u.fixed_length(MSG_LEN);}
+
+template<typename Packer, typename Unpacker, typename Socket> void setup_socket(Socket& s)
+{
+	setup_packer(dynamic_cast<Packer&>(*s.packer()));
+	setup_unpacker(dynamic_cast<Unpacker&>(*s.unpacker()));
+}
+
+template<typename Packer, typename Unpacker> class credit_server_socket : public ascs::tcp::server_socket_base<Packer, Unpacker>
+{
+public:
+	credit_server_socket(ascs::tcp::i_server& server_) : ascs::tcp::server_socket_base<Packer, Unpacker>(server_) {setup_socket<Packer, Unpacker>(*this);}
+
+protected:
+	virtual bool on_msg_handle(typename Unpacker::msg_type& msg)
+	{
+		if (MSG_LEN != msg.size())
+			++error_num;
+
+		++received_num;
+		return true;
+	}
+};
+
+template<typename Packer, typename Unpacker> class credit_client_socket : public ascs::tcp::client_socket_base<Packer, Unpacker>
+{
+public:
+	credit_client_socket(asio::io_context& io_context_) : ascs::tcp::client_socket_base<Packer, Unpacker>(io_context_) {setup_socket<Packer, Unpacker>(*this);}
+};
+
+//the client sends msg_num msgs to the server, credit flow control is only enabled if both the packer and the unpacker support credit
+// frames, otherwise, the sender must not wait for credits (which will never come).
+template<typename Packer, typename Unpacker> void test_credit(const char* name, size_t msg_num)
+{
+	received_num = error_num = 0;
+
+	service_pump sp;
+	ascs::tcp::server_base<credit_server_socket<Packer, Unpacker>> server(sp);
+	ascs::tcp::single_client_base<credit_client_socket<Packer, Unpacker>> client(sp);
+
+	sp.start_service(2);
+	auto begin_time = std::chrono::system_clock::now();
+	while (!client.is_connected() && std::chrono::system_clock::now() - begin_time < std::chrono::seconds(10))
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	begin_time = std::chrono::system_clock::now();
+	std::string msg(MSG_LEN, 'a');
+	for (size_t i = 0; i < msg_num; ++i)
+		if (!client.safe_send_msg(msg))
+			break;
+
+	while (received_num < msg_num && std::chrono::system_clock::now() - begin_time < std::chrono::seconds(30))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	auto used_time = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::system_clock::now() - begin_time).count();
+
+	printf("%-35s credit %-8s " ASCS_SF " of " ASCS_SF " msgs received, " ASCS_SF " error(s), %.3f seconds.\n",
+		name, client.is_credit_enabled() ? "enabled," : "disabled,", received_num.load(), msg_num, error_num.load(), used_time);
+	sp.stop_service();
+}
+
+int main(int argc, const char* argv[])
+{
+	printf("usage: %s [<msg number=10000>]\n", argv[0]);
+
+	size_t msg_num = 10000;
+	if (argc > 1)
+		msg_num = std::max((size_t) atoi(argv[1]), (size_t) 1);
+
+	test_credit<packer<>, unpacker<>>("packer/unpacker", msg_num);
+	test_credit<packer2<>, unpacker2<>>("packer2/unpacker2", msg_num);
+	test_credit<packer<>, flexible_unpacker<>>("packer/flexible_unpacker", msg_num);
+	test_credit<packer<>, non_copy_unpacker>("packer/non_copy_unpacker", msg_num);
+	test_credit<fixed_length_packer, fixed_length_unpacker>("fixed_length_packer/unpacker", msg_num);
+	test_credit<prefix_suffix_packer, prefix_suffix_unpacker>("prefix_suffix_packer/unpacker", msg_num);
+
+	return 0;
+}
@@ -0,0 +1,192 @@
+#include <iostream>
+
+//configuration
+#define ASCS_SERVER_PORT	9527
+//configuration
+
+#include <ascs/ext/tcp.h>
+using namespace ascs;
+using namespace ascs::ext;
+
+std::atomic_size_t received_num(0), error_num(0), max_concurrency(0);
+void update_max_concurrency(size_t num) {auto max_num = max_concurrency.load(); while (num > max_num && !max_concurrency.compare_exchange_weak(max_num, num));}
+
+//each msg carries its sequence number (per link), server sockets check the order of msgs and the thread which dispatches them.
+class seq_socket : public ascs::ext::tcp::server_socket
+{
+public:
+	static std::string make_msg(size_t seq) {return std::to_string(seq);}
+
+	seq_socket(ascs::tcp::i_server& server_) : ascs::ext::tcp::server_socket(server_), next_seq(0), concurrency(0) {}
+
+protected:
+	virtual bool on_msg_handle(out_msg_type& msg)
+	{
+		update_max_concurrency(++concurrency);
+		if (std::thread::id() == thread_id)
+			thread_id = std::this_thread::get_id();
+		else if (std::this_thread::get_id() != thread_id) //a socket always be dispatched by the same worker
+			++error_num;
+
+		if (make_msg(next_seq++) != std::string(msg.data(), msg.size()))
+			++error_num;
+
+		--concurrency;
+		++received_num;
+		return true;
+	}
+
+private:
+	size_t next_seq;
+	std::thread::id thread_id;
+	std::atomic_size_t concurrency;
+};
+
+//each msg carries a key and its sequence number (per key), msgs are dispatched concurrently by keys (see ascs::socket::dispatch_by_key),
+// server sockets check the order of msgs per key and how many msgs are being handled at the same time.
+class key_socket : public ascs::ext::tcp::server_socket
+{
+public:
+	static const size_t key_num = 8;
+	static std::string make_msg(size_t seq) {return std::to_string(seq % key_num) + ' ' + std::to_string(seq / key_num);}
+
+	key_socket(ascs::tcp::i_server& server_) : ascs::ext::tcp::server_socket(server_), next_seq(key_num, 0), concurrency(0)
+		{dispatch_by_key([](const out_msg_type& msg) {return (uint_fast64_t) (*msg.data() - '0');}, 4);}
+
+protected:
+	virtual bool on_msg_handle(out_msg_type& msg)
+	{
+		update_max_concurrency(++concurrency);
+		std::string str(msg.data(), msg.size());
+		auto key = (size_t) (str[0] - '0');
+		if (key >= key_num || str != std::to_string(key) + ' ' + std::to_string(next_seq[key]++)) //only this partition accesses next_seq[key]
+			++error_num;
+
+		std::this_thread::yield(); //give other partitions a chance to overlap
+		--concurrency;
+		++received_num;
+		return true;
+	}
+
+private:
+	std::vector<size_t> next_seq;
+	std::atomic_size_t concurrency;
+};
+
+//server sockets push msgs into the inbox of the server (see ascs::object_pool::inbox_consumer_num) rather than dispatching them one by one,
+// one consumer takes them out in batches and checks the order of msgs per link (with more consumers, batches can be handled concurrently).
+class inbox_server : public ascs::tcp::server_base<seq_socket>
+{
+public:
+	inbox_server(service_pump& service_pump_) : ascs::tcp::server_base<seq_socket>(service_pump_), concurrency(0) {inbox_consumer_num(1);}
+
+protected:
+	virtual void on_inbox_batch(inbox_type& batches)
+	{
+		update_max_concurrency(++concurrency);
+		for (auto& batch : batches)
+		{
+			auto& next_seq = next_seqs[batch.id];
+			for (auto& msg : batch.msgs)
+				if (seq_socket::make_msg(next_seq++) != std::string(msg.data(), msg.size()))
+					++error_num;
+			received_num += batch.msgs.size();
+		}
+		--concurrency;
+	}
+
+private:
+	std::unordered_map<uint_fast64_t, size_t> next_seqs;
+	std::atomic_size_t concurrency;
+};
+
+//client_num clients send msg_num msgs each, server sockets dispatch them in executor (null means service threads),
+// pool is the same object as executor (or an idle pool), just for statistic and stopping.
+template<typename Socket, typename Server = ascs::tcp::server_base<Socket>>
+void test_dispatch(const char* name, i_dispatch_executor* executor, dispatch_pool& pool, service_pump& sp, size_t client_num, size_t msg_num)
+{
+	received_num = error_num = max_concurrency = 0;
+
+	Server server(sp);
+	server.dispatch_executor(executor);
+	ascs::tcp::multi_client_base<ascs::ext::tcp::client_socket> client(sp);
+	for (size_t i = 0; i < client_num; ++i)
+		client.add_socket();
+
+	sp.start_service(2);
+	auto begin_time = std::chrono::system_clock::now();
+	size_t connected_num = 0;
+	while (std::chrono::system_clock::now() - begin_time < std::chrono::seconds(10))
+	{
+		connected_num = 0;
+		client.do_something_to_all([&](const std::shared_ptr<ascs::ext::tcp::client_socket>& item) {if (item->is_connected()) ++connected_num;});
+		if (connected_num >= client_num && server.size() >= client_num)
+			break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	begin_time = std::chrono::system_clock::now();
+	for (size_t j = 0; j < msg_num; ++j)
+		client.do_something_to_all([&](const std::shared_ptr<ascs::ext::tcp::client_socket>& item) {item->safe_send_msg(Socket::make_msg(j));});
+
+	auto total = client_num * msg_num;
+	while (received_num < total && std::chrono::system_clock::now() - begin_time < std::chrono::seconds(60))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	auto used_time = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::system_clock::now() - begin_time).count();
+	auto stat = pool.get_statistic();
+
+	sp.stop_service();
+	pool.stop(); //no-op for service_pump's own dispatch pool, it has been stopped by stop_service
+
+	printf("%-20s " ASCS_SF " connected, " ASCS_SF " of " ASCS_SF " msgs dispatched, " ASCS_SF " error(s), %.3f seconds, "
+		ASCS_LLF " handler(s) run by the pool, at most " ASCS_SF " msg(s) of a link handled at the same time.\n",
+		name, connected_num, received_num.load(), total, error_num.load(), used_time, stat.handled_num, max_concurrency.load());
+}
+
+int main(int argc, const char* argv[])
+{
+	printf("usage: %s [<client number=16> [<msg number per client=10000> [<dispatch thread number=4>]]]\n", argv[0]);
+
+	size_t client_num = 16, msg_num = 10000;
+	auto thread_num = 4;
+	if (argc > 1)
+		client_num = std::max((size_t) atoi(argv[1]), (size_t) 1);
+	if (argc > 2)
+		msg_num = std::max((size_t) atoi(argv[2]), (size_t) 1);
+	if (argc > 3)
+		thread_num = std::max(atoi(argv[3]), 1);
+
+	puts("\ndispatching in dispatch pools:");
+	{
+		service_pump sp;
+		sp.dispatch_thread_num(thread_num);
+		test_dispatch<seq_socket>("service_pump's pool", &sp.get_dispatch_pool(), sp.get_dispatch_pool(), sp, client_num, msg_num);
+	}
+	{
+		auto pool = new dispatch_pool();
+		std::unique_ptr<i_dispatch_executor> executor(pool); //freed via the interface
+		pool->start(thread_num);
+
+		service_pump sp;
+		test_dispatch<seq_socket>("user's pool", executor.get(), *pool, sp, client_num, msg_num);
+	}
+
+	puts("\ndispatching by keys:");
+	{
+		service_pump sp;
+		test_dispatch<key_socket>("service threads", nullptr, sp.get_dispatch_pool(), sp, client_num, msg_num);
+	}
+	{
+		service_pump sp;
+		sp.dispatch_thread_num(thread_num);
+		test_dispatch<key_socket>("service_pump's pool", &sp.get_dispatch_pool(), sp.get_dispatch_pool(), sp, client_num, msg_num);
+	}
+
+	puts("\ndispatching in the inbox:");
+	{
+		service_pump sp;
+		test_dispatch<seq_socket, inbox_server>("inbox", nullptr, sp.get_dispatch_pool(), sp, client_num, msg_num);
+	}
+
+	return 0;
+}
@@ -17,6 +17,8 @@
 //if there's a huge number of links, please reduce messge buffer via ASCS_MAX_SEND_BUF and ASCS_MAX_RECV_BUF macro.
 //please think about if we have 512 links, how much memory we can accupy at most with default ASCS_MAX_SEND_BUF and ASCS_MAX_RECV_BUF?
 //it's 2 * 1M * 512 = 1G
+//#define ASCS_INPUT_CONTAINER	pooled_list //cache list nodes in each thread, see macro ASCS_MAX_CACHED_NODE_NUM for more details
+//#define ASCS_OUTPUT_CONTAINER	pooled_list
 
 //use the following macro to control the type of packer and unpacker
 #define PACKER_UNPACKER_TYPE	0
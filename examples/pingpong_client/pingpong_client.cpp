@@ -6,6 +6,8 @@
 #define ASCS_REUSE_OBJECT //use objects pool
 #define ASCS_DELAY_CLOSE	5 //define this to avoid hooks for async call (and slightly improve efficiency)
 #define ASCS_SYNC_DISPATCH
+//#define ASCS_SYNC_RECV //receive msgs via sync_recv_msg in user threads (one per link) to benchmark sync message receiving
+//#define ASCS_SYNC_RECV_CHANNEL 64 //use the lock-free channel for sync message receiving, compare it with the above one
 //#define ASCS_WANT_MSG_SEND_NOTIFY
 #define ASCS_MSG_BUFFER_SIZE 65536
 #define ASCS_DEFAULT_UNPACKER stream_unpacker //non-protocol
@@ -46,6 +48,21 @@ public:
 		send_native_msg(msg, msg_len, false);
 	}
 
+#ifdef ASCS_SYNC_RECV
+	//call this in a dedicated thread, it returns after the link broken
+	void sync_recv_loop()
+	{
+		std::list<out_msg_type> msg_can;
+		auto re = sync_call_result::SUCCESS;
+		while (sync_call_result::SUCCESS == re || sync_call_result::TIMEOUT == re)
+		{
+			re = sync_recv_msg(msg_can, 50);
+			ascs::do_something_to_all(msg_can, [this](out_msg_type& msg) {this->handle_msg(msg);});
+			msg_can.clear();
+		}
+	}
+#endif
+
 protected:
 	virtual void on_connect() {asio::ip::tcp::no_delay option(true); lowest_layer().set_option(option); client_socket::on_connect();}
 
@@ -146,6 +163,10 @@ int main(int argc, const char* argv[])
 		client.add_socket(port, ip);
 
 	sp.start_service(thread_num);
+#ifdef ASCS_SYNC_RECV
+	std::list<std::thread> sync_recv_threads;
+	client.do_something_to_all([&](echo_client::object_ctype& item) {sync_recv_threads.emplace_back([item]() {item->sync_recv_loop();});});
+#endif
 	while(sp.is_running())
 	{
 		std::string str;
@@ -198,6 +219,10 @@ int main(int argc, const char* argv[])
 			delete[] init_msg;
 		}
 	}
+#ifdef ASCS_SYNC_RECV
+	for (auto& item : sync_recv_threads)
+		item.join();
+#endif
 
     return 0;
 }
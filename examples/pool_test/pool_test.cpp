@@ -0,0 +1,163 @@
+#include <iostream>
+
+//configuration
+#if __cplusplus >= 201402L //finding and traversing take shared locks
+#include <shared_mutex>
+#define ASCS_SHARED_MUTEX_TYPE	std::shared_timed_mutex
+#define ASCS_SHARED_LOCK_TYPE	std::shared_lock
+#endif
+//configuration
+
+#include <ascs/object_container.h>
+using namespace ascs;
+
+//object storages only need id() and obsoleted() (the latter for clear_obsoleted_object), so we don't need real sockets here,
+// and we don't need object_pool either (it's a service which needs service_pump), because it just forwards to its storage.
+class fake_object
+{
+public:
+	fake_object(uint_fast64_t id) : id_(id) {}
+
+	uint_fast64_t id() const {return id_;}
+	bool obsoleted() const {return false;}
+
+private:
+	uint_fast64_t id_;
+};
+
+//object_num objects are always in the storage, writer_num writers delete and re-add them continuously (like connection churn, each writer
+// manages its own ids), at the same time, reader_num readers find objects by random ids (like server.find(id)->send_msg), and one more thread
+// traverses all objects (like broadcast_msg or get_statistic), every thread does a fixed amount of work, then we measure how long the writers
+// and the readers take respectively.
+template<typename Container> void test_churn(const char* name, size_t object_num, size_t writer_num, size_t reader_num, size_t op_num)
+{
+	Container can;
+	for (size_t i = 0; i < object_num; ++i)
+		can.add(std::make_shared<fake_object>(i), -1);
+
+	std::atomic_size_t found_num(0), visited_num(0);
+	auto begin_time = std::chrono::system_clock::now();
+
+	std::list<std::thread> writers;
+	for (size_t i = 0; i < writer_num; ++i)
+		writers.emplace_back([&, i]() {
+			for (size_t j = 0; j < op_num; ++j)
+			{
+				auto object_ptr = can.del((uint_fast64_t) ((j * writer_num + i) % object_num));
+				if (object_ptr)
+					can.add(object_ptr, -1);
+			}
+		});
+
+	std::list<std::thread> readers;
+	for (size_t i = 0; i < reader_num; ++i)
+		readers.emplace_back([&, i]() {
+			size_t num = 0;
+			auto id = (uint_fast64_t) i;
+			for (size_t j = 0; j < op_num; ++j, id = id * 6364136223846793005ULL + 1442695040888963407ULL) //lcg
+				if (can.find(id % object_num))
+					++num;
+			found_num += num;
+		});
+	readers.emplace_back([&]() {
+		std::string msg(64, 'a');
+		for (size_t j = 0; j < std::max(op_num / object_num, (size_t) 1); ++j)
+			can.do_something_to_all([&](const std::shared_ptr<fake_object>& item) {
+				msg[0] = (char) item->id(); //simulate packing a message for each object (like broadcast_msg)
+				if (std::hash<std::string>()(msg) > 0)
+					visited_num.fetch_add(1, std::memory_order_relaxed);
+			});
+	});
+
+	for (auto& item : writers)
+		item.join();
+	auto writer_time = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::system_clock::now() - begin_time).count();
+	for (auto& item : readers)
+		item.join();
+	auto reader_time = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::system_clock::now() - begin_time).count();
+
+	printf("%-20s %u writer(s), %u reader(s), writers %.3f seconds (%.0f churns/s), readers %.3f seconds, "
+		ASCS_SF " found, " ASCS_SF " visited, " ASCS_SF " objects left.\n",
+		name, (unsigned) writer_num, (unsigned) reader_num, writer_time, writer_num * op_num / writer_time, reader_time,
+		found_num.load(), visited_num.load(), can.size());
+}
+
+//one thread accesses objects by random indexes (like echo_client's random_send_msg), then traverses all objects (like broadcast_msg)
+template<typename Container> void test_access(const char* name, size_t object_num, size_t op_num)
+{
+	Container can;
+	for (size_t i = 0; i < object_num; ++i)
+		can.add(std::make_shared<fake_object>(i), -1);
+
+	size_t num = 0;
+	auto begin_time = std::chrono::system_clock::now();
+	for (size_t i = 0, index = 0; i < op_num / 100; ++i, index = (index * 1103515245 + 12345) % object_num) //at is linear in some storages
+		num += can.at(index)->id() & 1;
+	auto at_time = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::system_clock::now() - begin_time).count();
+
+	begin_time = std::chrono::system_clock::now();
+	for (size_t i = 0; i < std::max(op_num / object_num, (size_t) 1); ++i)
+		can.do_something_to_all([&](const std::shared_ptr<fake_object>& item) {num += item->id() & 1;});
+	auto traverse_time = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::system_clock::now() - begin_time).count();
+
+	printf("%-20s " ASCS_SF " random at: %.3f seconds, " ASCS_SF " traversals: %.3f seconds (" ASCS_SF ").\n",
+		name, op_num / 100, at_time, std::max(op_num / object_num, (size_t) 1), traverse_time, num);
+}
+
+//object_pool calls change_id on objects which have not been added yet (see object_pool::add_object), storages must count them as new
+// objects, no matter whether the old ids and the new ids are in the same shard or not (sharded_object_map), if std::hash<uint_fast64_t>
+// is identity, half of the old ids are in the same shards as the new ids.
+template<typename Container> void test_change_id(const char* name, size_t object_num)
+{
+	Container can;
+	size_t changed_num = 0;
+	for (size_t i = 0; i < object_num; ++i)
+		if (can.change_id(std::make_shared<fake_object>(16 * object_num + i + (i & 1)), i)) //not in the storage
+			++changed_num;
+
+	//objects which have been added
+	for (size_t i = 0; i < object_num; ++i)
+	{
+		auto object_ptr = std::make_shared<fake_object>(2 * object_num + i);
+		if (can.add(object_ptr, -1) && can.change_id(object_ptr, 3 * object_num + i))
+			++changed_num;
+	}
+
+	printf("%-20s " ASCS_SF " ids changed, size() returns " ASCS_SF " (%s).\n", name, changed_num, can.size(), changed_num == can.size() ? "right" : "wrong");
+}
+
+int main(int argc, const char* argv[])
+{
+	printf("usage: %s [<max writer number=8> [<object number=100000> [<operation number per thread=1000000>]]]\n", argv[0]);
+
+	size_t max_writer_num = 8, object_num = 100000, op_num = 1000000;
+	if (argc > 1)
+		max_writer_num = std::max((size_t) atoi(argv[1]), (size_t) 1);
+	if (argc > 2)
+		object_num = std::max((size_t) atoi(argv[2]), (size_t) 1);
+	if (argc > 3)
+		op_num = std::max((size_t) atoi(argv[3]), (size_t) 1);
+
+	puts("\nconnection churn (writers) with finding and traversing (readers):");
+	for (size_t writer_num = 1; writer_num <= max_writer_num; writer_num *= 2)
+	{
+		test_churn<object_map<fake_object>>("object_map", object_num, writer_num, writer_num, op_num);
+		test_churn<sharded_object_map<fake_object>>("sharded_object_map", object_num, writer_num, writer_num, op_num);
+		test_churn<slot_object_map<fake_object>>("slot_object_map", object_num, writer_num, writer_num, op_num);
+		test_churn<snapshot_object_map<fake_object>>("snapshot_object_map", object_num, writer_num, writer_num, op_num);
+	}
+
+	puts("\nrandom access and traversing (one thread):");
+	test_access<object_map<fake_object>>("object_map", object_num, op_num);
+	test_access<sharded_object_map<fake_object>>("sharded_object_map", object_num, op_num);
+	test_access<slot_object_map<fake_object>>("slot_object_map", object_num, op_num);
+	test_access<snapshot_object_map<fake_object>>("snapshot_object_map", object_num, op_num);
+
+	puts("\nchanging ids:");
+	test_change_id<object_map<fake_object>>("object_map", 1000);
+	test_change_id<sharded_object_map<fake_object>>("sharded_object_map", 1000);
+	test_change_id<slot_object_map<fake_object>>("slot_object_map", 1000);
+	test_change_id<snapshot_object_map<fake_object>>("snapshot_object_map", 1000);
+
+	return 0;
+}
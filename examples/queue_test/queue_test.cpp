@@ -0,0 +1,216 @@
+
+#include <iostream>
+
+//configuration
+#define ASCS_MAX_SEND_BUF	65536 //just as asio::detail::default_max_transfer_size, the size of each batch fetched by the consumer
+//configuration
+
+#include <ascs/container.h>
+using namespace ascs;
+
+typedef std::string msg_type;
+
+//many producers send messages to one queue concurrently (like many threads send messages to one socket), and one consumer fetches
+// them in batches (like tcp::socket_base::do_send_msg)
+template<typename Queue> void test_input_queue(const char* name, size_t producer_num, size_t msg_num, size_t msg_len)
+{
+	Queue queue;
+	auto total_msg_num = producer_num * msg_num;
+	std::atomic_size_t sent_msg_num(0);
+
+	auto begin_time = std::chrono::system_clock::now();
+	std::thread consumer([&]() {
+		typename Queue::container_type msg_can;
+		for (size_t recv_msg_num = 0; recv_msg_num < total_msg_num;)
+		{
+			queue.move_items_out(ASCS_MAX_SEND_BUF, msg_can);
+			if (msg_can.empty())
+				std::this_thread::yield();
+			else
+			{
+				recv_msg_num += msg_can.size();
+				msg_can.clear();
+			}
+		}
+	});
+
+	std::list<std::thread> producers;
+	for (size_t i = 0; i < producer_num; ++i)
+		producers.emplace_back([&]() {
+			for (size_t j = 0; j < msg_num; ++j)
+				queue.enqueue(msg_type(msg_len, 'a'));
+			sent_msg_num += msg_num;
+		});
+
+	for (auto& item : producers)
+		item.join();
+	consumer.join();
+
+	auto used_time = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::system_clock::now() - begin_time).count();
+	printf("%-16s %u producer(s), " ASCS_SF " msgs, %.3f seconds, %.0f msgs/s, left " ASCS_SF " bytes.\n",
+		name, (unsigned) producer_num, sent_msg_num.load(), used_time, total_msg_num / used_time, queue.size_in_byte());
+}
+
+//one producer puts messages into one queue in batches (like socket::handle_msg), and one consumer fetches them in batches
+// (like on_msg_handle with macro ASCS_DISPATCH_BATCH_MSG)
+template<typename Queue> void test_output_queue(const char* name, size_t msg_num, size_t msg_len)
+{
+	Queue queue;
+	auto begin_time = std::chrono::system_clock::now();
+	std::thread consumer([&]() {
+		typename Queue::container_type msg_can;
+		for (size_t recv_msg_num = 0; recv_msg_num < msg_num;)
+		{
+			queue.swap(msg_can);
+			if (msg_can.empty())
+				std::this_thread::yield();
+			else
+			{
+				recv_msg_num += msg_can.size();
+				msg_can.clear();
+			}
+		}
+	});
+
+	for (size_t i = 0; i < msg_num;)
+	{
+		typename Queue::container_type msg_can;
+		for (size_t j = 0; j < 16 && i < msg_num; ++j, ++i) //16 messages per reading
+			msg_can.emplace_back(msg_len, 'a');
+		for (queue.move_items_in(msg_can); !msg_can.empty(); queue.move_items_in(msg_can))
+			std::this_thread::yield(); //bounded queues (spsc_queue) leave msgs in msg_can if they're full, wait for the consumer
+	}
+	consumer.join();
+
+	auto used_time = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::system_clock::now() - begin_time).count();
+	printf("%-28s " ASCS_SF " msgs, %.3f seconds, %.0f msgs/s, left " ASCS_SF " bytes.\n", name, msg_num, used_time, msg_num / used_time, queue.size_in_byte());
+}
+
+//fetch messages from a queue which holds a huge number of tiny messages in batches (like tcp::socket_base::do_send_msg)
+template<template<typename> class Container> void test_batch_fetching(const char* name, size_t msg_num, size_t msg_len)
+{
+	non_lock_queue<Container<msg_type>> queue;
+	for (size_t i = 0; i < msg_num; ++i)
+		queue.enqueue(msg_type(msg_len, 'a'));
+
+	size_t batch_num = 0;
+	auto begin_time = std::chrono::system_clock::now();
+	for (Container<msg_type> msg_can; !queue.empty(); msg_can.clear(), ++batch_num)
+		queue.move_items_out(ASCS_MAX_SEND_BUF, msg_can);
+
+	auto used_time = std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::system_clock::now() - begin_time).count();
+	printf("%-12s " ASCS_SF " msgs, " ASCS_SF " batches, %.3f seconds, %.0f msgs/s.\n", name, msg_num, batch_num, used_time, msg_num / used_time);
+}
+
+//a backlog of bulk messages is waiting to be sent, then a control message (a heartbeat for example) comes, how many batches (and bytes)
+// will be fetched (like tcp::socket_base::do_send_msg) before the control message
+template<typename Queue> void test_control_msg(const char* name, Queue& queue, size_t msg_num, size_t msg_len, bool use_lane)
+{
+	for (size_t i = 0; i < msg_num; ++i)
+		if (use_lane)
+			queue.enqueue(msg_type(msg_len, 'a'), lane(Queue::lane_num - 1)); //bulk messages go to the lowest lane
+		else
+			queue.enqueue(msg_type(msg_len, 'a'));
+	queue.enqueue(msg_type("heartbeat")); //lane 0
+
+	size_t batch_num = 0, size = 0;
+	for (list<msg_type> msg_can; !queue.empty(); msg_can.clear())
+	{
+		queue.move_items_out(ASCS_MAX_SEND_BUF, msg_can);
+		++batch_num;
+		auto found = false;
+		for (auto iter = std::begin(msg_can); !found && iter != std::end(msg_can); ++iter)
+			if (!(found = "heartbeat" == *iter))
+				size += iter->size();
+		if (found)
+			break;
+	}
+
+	printf("%-32s the control msg was fetched in batch " ASCS_SF ", after " ASCS_SF " bytes.\n", name, batch_num, size);
+	queue.clear();
+}
+
+//the first 4 bytes of a price message is its key (the stock id for example)
+struct price_key
+{
+	typedef uint32_t key_type;
+	bool operator()(const msg_type& msg, key_type& key) const {if (msg.size() < sizeof(key_type)) return false; memcpy(&key, msg.data(), sizeof(key_type)); return true;}
+};
+template<typename Container> using price_queue = conflating_queue<Container, price_key>;
+
+template<typename Queue> auto get_conflated_msg_num(const Queue& queue, int) -> decltype(queue.conflated_msg_num()) {return queue.conflated_msg_num();}
+template<typename Queue> uint_fast64_t get_conflated_msg_num(const Queue& queue, long) {return 0;} //queues which don't conflate
+
+//a fast producer keeps updating the prices of key_num keys, and a slow consumer fetches one (small) batch after every 100 updates
+template<typename Queue> void test_conflation(const char* name, size_t msg_num, size_t msg_len, size_t key_num)
+{
+	Queue queue;
+	size_t max_size = 0, recv_msg_num = 0;
+	for (size_t i = 0; i < msg_num; ++i)
+	{
+		auto key = (uint32_t) (i % key_num);
+		msg_type msg(std::max(msg_len, sizeof(key)), 'a');
+		memcpy(&msg[0], &key, sizeof(key));
+		queue.enqueue(std::move(msg));
+		max_size = std::max(max_size, queue.size_in_byte());
+
+		if (0 == i % 100)
+		{
+			typename Queue::container_type msg_can;
+			queue.move_items_out(ASCS_MAX_SEND_BUF / 64, msg_can);
+			recv_msg_num += msg_can.size();
+		}
+	}
+
+	printf("%-16s " ASCS_SF " msgs, " ASCS_SF " fetched, " ASCS_SF " conflated, the max backlog is " ASCS_SF " bytes.\n",
+		name, msg_num, recv_msg_num, (size_t) get_conflated_msg_num(queue, 0), max_size);
+}
+
+template<template<typename> class Queue, template<typename> class Container = list>
+struct output_queue : public Queue<Container<msg_type>> {typedef Container<msg_type> container_type;};
+template<template<typename> class Queue> struct input_queue : public Queue<list<msg_type>> {typedef list<msg_type> container_type;};
+
+int main(int argc, const char* argv[])
+{
+	printf("usage: %s [<max producer number=16> [<message number per producer=1000000> [<message length=64>]]]\n", argv[0]);
+
+	size_t max_producer_num = 16, msg_num = 1000000, msg_len = 64;
+	if (argc > 1)
+		max_producer_num = std::max((size_t) atoi(argv[1]), (size_t) 1);
+	if (argc > 2)
+		msg_num = std::max((size_t) atoi(argv[2]), (size_t) 1);
+	if (argc > 3)
+		msg_len = (size_t) atoi(argv[3]);
+
+	puts("\ninput queue (multiple producers, one consumer):");
+	for (size_t producer_num = 1; producer_num <= max_producer_num; producer_num *= 2)
+	{
+		test_input_queue<input_queue<lock_queue>>("lock_queue", producer_num, msg_num, msg_len);
+		test_input_queue<input_queue<lock_free_queue>>("lock_free_queue", producer_num, msg_num, msg_len);
+	}
+
+	puts("\noutput queue (one producer, one consumer):");
+	test_output_queue<output_queue<lock_queue>>("lock_queue + list", msg_num, msg_len);
+	test_output_queue<output_queue<lock_queue, ring_buffer>>("lock_queue + ring_buffer", msg_num, msg_len);
+	test_output_queue<output_queue<spsc_queue>>("spsc_queue + list", msg_num, msg_len);
+	test_output_queue<output_queue<spsc_queue, ring_buffer>>("spsc_queue + ring_buffer", msg_num, msg_len);
+
+	puts("\nbatch fetching (by bytes, one thread):");
+	test_batch_fetching<list>("list", msg_num, std::min(msg_len, (size_t) 8));
+	test_batch_fetching<pooled_list>("pooled_list", msg_num, std::min(msg_len, (size_t) 8));
+	test_batch_fetching<ring_buffer>("ring_buffer", msg_num, std::min(msg_len, (size_t) 8));
+	test_batch_fetching<chunk_deque>("chunk_deque", msg_num, std::min(msg_len, (size_t) 8));
+
+	puts("\ncontrol msg after a backlog of bulk msgs:");
+	multi_lane_queue<list<msg_type>> queue;
+	test_control_msg("one lane", queue, msg_num, msg_len, false);
+	test_control_msg("multiple lanes (strict)", queue, msg_num, msg_len, true);
+	queue.set_policy(decltype(queue)::WEIGHTED);
+	test_control_msg("multiple lanes (weighted)", queue, msg_num, msg_len, true);
+
+	puts("\nfast producer and slow consumer (1000 keys):");
+	test_conflation<input_queue<lock_queue>>("lock_queue", msg_num, msg_len, 1000);
+	test_conflation<input_queue<price_queue>>("conflating_queue", msg_num, msg_len, 1000);
+
+	return 0;
+}
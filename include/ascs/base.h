@@ -26,10 +26,9 @@
 #include <atomic>
 #include <sstream>
 #include <iomanip>
-#ifdef ASCS_SYNC_SEND
-#include <future>
-#elif defined(ASCS_SYNC_RECV)
 #include <condition_variable>
+#ifdef ASCS_COROUTINE
+#include <coroutine>
 #endif
 
 #include <asio.hpp>
@@ -76,6 +75,36 @@ public:
 	virtual bool del_socket(uint_fast64_t id) = 0;
 };
 
+//object_pool implements this interface, sockets created by object_pool use it to inform object_pool that they finished closing,
+//then object_pool can move them to the ready list (of invalid objects) without scanning, see object_pool::on_obsoleted for more details.
+class i_object_pool
+{
+public:
+	virtual void on_obsoleted(uint_fast64_t id) = 0;
+};
+
+//sockets can run msg dispatching (on_msg_handle) in an executor other than service threads, see ascs::socket::dispatch_executor.
+//handlers posted with the same key (socket id) must be invoked one by one and in the posting order (by the same thread for example),
+//then msgs of a socket will be dispatched in sequence without strands, dispatch_pool (in service_pump.h) is the default implementation.
+class i_dispatch_executor
+{
+public:
+	virtual ~i_dispatch_executor() {}
+
+	virtual void post(uint_fast64_t key, std::function<void()>&& handler) = 0;
+};
+
+//sockets can push msgs into an inbox rather than their own receiving buffer (fan-in), see ascs::object_pool::inbox_consumer_num.
+template<typename Msg> class i_inbox
+{
+public:
+	//msgs will be moved into the inbox.
+	virtual void push(uint_fast64_t id, std::list<Msg>& msgs, size_t size_in_byte) = 0;
+	//return false if the inbox's budget has been used up, then the socket (id) will suspend message receiving, and the inbox must
+	// call its ascs::socket::resume_recv() after the inbox been drained.
+	virtual bool is_available(uint_fast64_t id) = 0;
+};
+
 namespace tcp
 {
 	class i_server : public i_matrix
@@ -166,6 +195,8 @@ public:
 	virtual bool pack_msg(msg_type&& msg1, msg_type&& msg2, container_type& msg_can) {return false;}
 	virtual bool pack_msg(container_type& in, container_type& out) {return false;}
 	virtual msg_type pack_heartbeat() {return msg_type();}
+	//the peer can send edge bytes in total (on this connection), return an empty msg if not supported, see macro ASCS_CREDIT_FLOW_CONTROL.
+	virtual msg_type pack_credit(uint_fast64_t edge) {return msg_type();}
 
 	//this default implementation is meaningless, just satisfy compilers
 	virtual char* raw_data(msg_type& msg) const {return const_cast<char*>(msg.data());}
@@ -214,6 +245,12 @@ public:
 	virtual bool parse_msg(size_t bytes_transferred, container_type& msg_can) = 0;
 	virtual size_t completion_condition(const asio::error_code& ec, size_t bytes_transferred) {return 0;}
 	virtual buffer_type prepare_next_recv() = 0;
+	//the biggest credit edge received from credit frames (which must not be included in msg_can), 0 means none or not supported,
+	// it must be cleared in reset(), see macro ASCS_CREDIT_FLOW_CONTROL.
+	virtual uint_fast64_t credit_edge() const {return 0;}
+	//whether this unpacker can parse credit frames (see credit_edge), credit flow control will only be enabled if both the packer and the
+	// unpacker support it, otherwise the sender would wait for credits forever.
+	virtual bool supports_credit() const {return false;}
 
 	//this default implementation is meaningless, just satisfy compilers
 	virtual char* raw_data(msg_type& msg) const {return const_cast<char*>(msg.data());}
@@ -320,6 +357,10 @@ struct statistic
 	{
 		send_msg_sum = 0;
 		send_byte_sum = 0;
+		send_coalesced_byte_sum = 0;
+		send_saved_write_sum = 0;
+		send_expired_msg_sum = 0;
+		send_expired_byte_sum = 0;
 
 		recv_msg_sum = 0;
 		recv_byte_sum = 0;
@@ -338,6 +379,7 @@ struct statistic
 		send_delay_sum.reset();
 		send_time_sum.reset();
 		pack_time_sum.reset();
+		send_credit_wait_sum.reset();
 
 		dispatch_delay_sum.reset();
 		recv_idle_sum.reset();
@@ -352,9 +394,14 @@ struct statistic
 	{
 		send_msg_sum += other.send_msg_sum;
 		send_byte_sum += other.send_byte_sum;
+		send_coalesced_byte_sum += other.send_coalesced_byte_sum;
+		send_saved_write_sum += other.send_saved_write_sum;
+		send_expired_msg_sum += other.send_expired_msg_sum;
+		send_expired_byte_sum += other.send_expired_byte_sum;
 		send_delay_sum += other.send_delay_sum;
 		send_time_sum += other.send_time_sum;
 		pack_time_sum += other.pack_time_sum;
+		send_credit_wait_sum += other.send_credit_wait_sum;
 
 		recv_msg_sum += other.recv_msg_sum;
 		recv_byte_sum += other.recv_byte_sum;
@@ -378,9 +425,14 @@ struct statistic
 	{
 		send_msg_sum -= other.send_msg_sum;
 		send_byte_sum -= other.send_byte_sum;
+		send_coalesced_byte_sum -= other.send_coalesced_byte_sum;
+		send_saved_write_sum -= other.send_saved_write_sum;
+		send_expired_msg_sum -= other.send_expired_msg_sum;
+		send_expired_byte_sum -= other.send_expired_byte_sum;
 		send_delay_sum -= other.send_delay_sum;
 		send_time_sum -= other.send_time_sum;
 		pack_time_sum -= other.pack_time_sum;
+		send_credit_wait_sum -= other.send_credit_wait_sum;
 
 		recv_msg_sum -= other.recv_msg_sum;
 		recv_byte_sum -= other.recv_byte_sum;
@@ -404,8 +456,11 @@ struct statistic
 	{
 		std::ostringstream s;
 		s << "send relevant statistic:\nmessage sum: " << send_msg_sum << std::endl << "size in bytes: " << send_byte_sum << std::endl
+			<< "coalesced bytes: " << send_coalesced_byte_sum << std::endl << "saved writes: " << send_saved_write_sum << std::endl
+			<< "expired messages: " << send_expired_msg_sum << std::endl << "expired bytes: " << send_expired_byte_sum << std::endl
 #ifdef ASCS_FULL_STATISTIC
 			<< "send delay: " << send_delay_sum << std::endl << "send duration: " << send_time_sum << std::endl << "pack duration: " << pack_time_sum << std::endl
+			<< "credit wait duration: " << send_credit_wait_sum << std::endl
 #endif
 			<< "\nrecv relevant statistic:\nmessage sum: " << recv_msg_sum << std::endl << "size in bytes: " << recv_byte_sum
 #ifdef ASCS_FULL_STATISTIC
@@ -418,10 +473,15 @@ struct statistic
 	//send relevant statistic
 	uint_fast64_t send_msg_sum; //not counted msgs in sending buffer
 	uint_fast64_t send_byte_sum; //include data added by packer, not counted msgs in sending buffer
+	uint_fast64_t send_coalesced_byte_sum; //bytes copied into the staging block, see macro ASCS_SEND_COALESCE_SIZE, tcp only
+	uint_fast64_t send_saved_write_sum; //msgs which joined a corked write rather than starting their own, see macro ASCS_SEND_CORK_DELAY, tcp only
+	uint_fast64_t send_expired_msg_sum; //msgs dropped because of their deadlines, see macro ASCS_MSG_DEADLINE
+	uint_fast64_t send_expired_byte_sum; //include data added by packer
 	stat_duration send_delay_sum; //from send_(native_)msg (exclude msg packing) to asio::async_write
 	stat_duration send_time_sum; //from asio::async_write to send_handler
 	//above two items indicate your network's speed or load
 	stat_duration pack_time_sum; //udp::socket_base will not gather this item
+	stat_duration send_credit_wait_sum; //during this duration, sending was blocked by the peer's credit, see macro ASCS_CREDIT_FLOW_CONTROL, tcp only
 
 	//recv relevant statistic
 	uint_fast64_t recv_msg_sum; //msgs returned by i_unpacker::parse_msg
@@ -454,29 +514,311 @@ private:
 
 enum sync_call_result {SUCCESS, NOT_APPLICABLE, DUPLICATE, TIMEOUT};
 
+//specify which lane msgs will be put into when sending them, lane 0 has the highest priority, see multi_lane_queue for more details.
+//the constructor is explicit, so it will never be mixed up with the 'bool can_overflow' parameter of msg sending interfaces.
+struct lane
+{
+	explicit lane(size_t id_) : id(id_) {}
+	size_t id;
+};
+
+#ifdef ASCS_MSG_DEADLINE
+//specify the deadline of msgs when sending them, msgs still in the send buffer at that time will be dropped rather than sent, see
+// macro ASCS_MSG_DEADLINE for more details. the constructors are explicit for the same reason as lane.
+struct deadline
+{
+	explicit deadline(unsigned ttl, bool prior_ = false) : time(std::chrono::steady_clock::now() + std::chrono::milliseconds(ttl)), prior(prior_) {}
+	//std::chrono::steady_clock::time_point::max() means never expire too
+	explicit deadline(const std::chrono::steady_clock::time_point& time_, bool prior_ = false) :
+		time(std::chrono::steady_clock::time_point::max() == time_ ? std::chrono::steady_clock::time_point() : time_), prior(prior_) {}
+
+	std::chrono::steady_clock::time_point time; //the epoch means never expire
+	bool prior; //put msgs at the front of the send buffer or not
+};
+#endif
+
 template<typename T> struct obj_with_begin_time : public T
 {
 	obj_with_begin_time() {}
 	obj_with_begin_time(const T& obj) : T(obj) {restart();}
 	obj_with_begin_time(T&& obj) : T(std::move(obj)) {restart();}
+#ifdef ASCS_MSG_DEADLINE
+	obj_with_begin_time& operator=(const T& obj) {T::operator=(obj); restart(); expire_time = std::chrono::steady_clock::time_point(); return *this;}
+	obj_with_begin_time& operator=(T&& obj) {T::operator=(std::move(obj)); restart(); expire_time = std::chrono::steady_clock::time_point(); return *this;}
+	obj_with_begin_time(const obj_with_begin_time& other) : T(other), begin_time(other.begin_time), expire_time(other.expire_time) {}
+	obj_with_begin_time(obj_with_begin_time&& other) : T(std::move(other)), begin_time(std::move(other.begin_time)), expire_time(other.expire_time) {}
+	obj_with_begin_time& operator=(const obj_with_begin_time& other)
+		{T::operator=(other); begin_time = other.begin_time; expire_time = other.expire_time; return *this;}
+	obj_with_begin_time& operator=(obj_with_begin_time&& other)
+		{T::operator=(std::move(other)); begin_time = std::move(other.begin_time); expire_time = other.expire_time; return *this;}
+#else
 	obj_with_begin_time& operator=(const T& obj) {T::operator=(obj); restart(); return *this;}
 	obj_with_begin_time& operator=(T&& obj) {T::operator=(std::move(obj)); restart(); return *this;}
 	obj_with_begin_time(const obj_with_begin_time& other) : T(other), begin_time(other.begin_time) {}
 	obj_with_begin_time(obj_with_begin_time&& other) : T(std::move(other)), begin_time(std::move(other.begin_time)) {}
 	obj_with_begin_time& operator=(const obj_with_begin_time& other) {T::operator=(other); begin_time = other.begin_time; return *this;}
 	obj_with_begin_time& operator=(obj_with_begin_time&& other) {T::operator=(std::move(other)); begin_time = std::move(other.begin_time); return *this;}
+#endif
 
 	void restart() {restart(statistic::now());}
 	void restart(const typename statistic::stat_time& begin_time_) {begin_time = begin_time_;}
+#ifdef ASCS_MSG_DEADLINE
+	void swap(T& obj) {T::swap(obj); restart(); expire_time = std::chrono::steady_clock::time_point();}
+	void swap(obj_with_begin_time& other) {T::swap(other); std::swap(begin_time, other.begin_time); std::swap(expire_time, other.expire_time);}
+
+	void clear() {T::clear(); begin_time = typename statistic::stat_time(); expire_time = std::chrono::steady_clock::time_point();}
+	bool expired(const std::chrono::steady_clock::time_point& now) const
+		{return std::chrono::steady_clock::time_point() != expire_time && !follows_prev() && now >= expire_time;}
+	//items packed together (a msg can be packed into more than one item) must be sent or dropped together, so only the first one carries the
+	// deadline, the others follow it (they're always adjacent in the send buffer).
+	bool follows_prev() const {return std::chrono::steady_clock::time_point::max() == expire_time;}
+	void follow_prev() {expire_time = std::chrono::steady_clock::time_point::max();}
+#else
 	void swap(T& obj) {T::swap(obj); restart();}
 	void swap(obj_with_begin_time& other) {T::swap(other); std::swap(begin_time, other.begin_time);}
 
 	void clear() {T::clear(); begin_time = typename statistic::stat_time();}
+#endif
 
 	typename statistic::stat_time begin_time;
+#ifdef ASCS_MSG_DEADLINE
+	std::chrono::steady_clock::time_point expire_time; //the epoch means never expire, max() means follow the previous item, see macro ASCS_MSG_DEADLINE
+#endif
+};
+
+//an allocator which caches freed memory blocks (only for single object allocations, like list nodes) in a thread local free list,
+// each thread caches ASCS_MAX_CACHED_NODE_NUM memory blocks at most, memory blocks beyond that will be moved to a global free list
+// in batches (and then be fetched by threads which run out of cached memory blocks), or be freed if the global free list is also full.
+//so memory blocks allocated in one thread (for example, messages sending) and freed in another thread (for example, service threads)
+// will be reused too.
+//it's stateless, so all instances are equal, which means std::list::splice is still O(1).
+template<typename T>
+class pooled_allocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	template<typename U> struct rebind {typedef pooled_allocator<U> other;};
+
+	pooled_allocator() {}
+	template<typename U> pooled_allocator(const pooled_allocator<U>&) {}
+
+	T* allocate(size_t n) {return 1 == n ? (T*) get_free_list().get() : std::allocator<T>().allocate(n);}
+	void deallocate(T* p, size_t n) {if (1 == n) get_free_list().put(p); else std::allocator<T>().deallocate(p, n);}
+
+	template<typename U, typename... Args> void construct(U* p, Args&&... args) {new (p) U(std::forward<Args>(args)...);}
+	template<typename U> void destroy(U* p) {p->~U();}
+	size_t max_size() const {return std::allocator<T>().max_size();}
+
+	template<typename U> bool operator==(const pooled_allocator<U>&) const {return true;}
+	template<typename U> bool operator!=(const pooled_allocator<U>&) const {return false;}
+
+private:
+	union block {block* next; typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type data;};
+	static const size_t BATCH_SIZE = 64; //how many memory blocks will be exchanged with the global free list each time
+
+	//batches can be shorter than BATCH_SIZE (if ASCS_MAX_CACHED_NODE_NUM is smaller than it), so each batch carries its length.
+	class global_free_list
+	{
+	public:
+		global_free_list() : num(0) {}
+
+		bool put(block* batch, size_t batch_size)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (num + batch_size > ASCS_MAX_CACHED_NODE_NUM)
+				return false;
+
+			batches.emplace_back(batch, batch_size);
+			num += batch_size;
+			return true;
+		}
+
+		block* get(size_t& batch_size)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (batches.empty())
+				return nullptr;
+
+			auto re = batches.back();
+			batches.pop_back();
+			num -= re.second;
+			batch_size = re.second;
+			return re.first;
+		}
+
+	private:
+		std::mutex mutex;
+		std::vector<std::pair<block*, size_t>> batches;
+		size_t num; //how many nodes in batches
+	};
+
+	class free_list
+	{
+	public:
+		free_list() : head(nullptr), num(0) {}
+		~free_list() {free(head);}
+
+		void* get()
+		{
+			if (nullptr == head)
+				head = get_global_free_list().get(num);
+
+			if (nullptr == head)
+				return ::operator new(sizeof(block));
+
+			auto re = head;
+			head = head->next;
+			--num;
+			return re;
+		}
+
+		void put(void* p)
+		{
+			auto b = (block*) p;
+			b->next = head;
+			head = b;
+
+			if (++num > ASCS_MAX_CACHED_NODE_NUM)
+			{
+				auto batch = head;
+				auto last = head;
+				size_t batch_size = 1;
+				for (; batch_size < BATCH_SIZE && nullptr != last->next; ++batch_size)
+					last = last->next;
+
+				head = last->next;
+				last->next = nullptr;
+				num -= batch_size;
+				if (!get_global_free_list().put(batch, batch_size))
+					free(batch);
+			}
+		}
+
+	private:
+		static void free(block* b) {while (nullptr != b) {auto next = b->next; ::operator delete(b); b = next;}}
+
+	private:
+		block* head;
+		size_t num;
+	};
+
+	static free_list& get_free_list() {static thread_local free_list list; return list;}
+	//never be destroyed, because threads may still access it during process exiting (after static objects been destroyed)
+	static global_free_list& get_global_free_list() {static auto list = new global_free_list; return *list;}
 };
 
 #ifdef ASCS_SYNC_SEND
+//the completion of a msg (sent or failed), it's invoked by the socket only once, normally in service threads, but if the msg been dropped
+// (popped, shed, discarded, expired or the socket been reset), it's invoked in the thread which dropped it.
+class i_send_completion
+{
+public:
+	virtual ~i_send_completion() {}
+	virtual void complete(sync_call_result re) = 0; //SUCCESS means the msg has been sent to the kernel buffer, otherwise NOT_APPLICABLE
+};
+
+#if defined(_MSC_VER) && _MSC_VER < 1900 //Visual C++ 12.0 (2013) doesn't support thread_local
+template<typename T, typename... Args> std::shared_ptr<T> make_send_completion(Args&&... args) {return std::make_shared<T>(std::forward<Args>(args)...);}
+#else
+template<typename T, typename... Args> std::shared_ptr<T> make_send_completion(Args&&... args)
+	{return std::allocate_shared<T>(pooled_allocator<T>(), std::forward<Args>(args)...);}
+#endif
+
+//the state of sync msg sending, it replaces std::promise and std::future, which allocate a shared state for each msg, states are
+// allocated via pooled_allocator, so there's no memory allocation after warming up, and the condition variable will not be touched
+// (neither by the waiting thread nor by the completing thread) if the msg has been sent before the waiting thread starts to wait.
+class sync_send_state
+{
+public:
+	sync_send_state() : result(sync_call_result::NOT_APPLICABLE), state(IDLE) {}
+
+	void complete(sync_call_result re)
+	{
+		result = re;
+		if (WAITING == state.exchange(DONE, std::memory_order_acq_rel))
+		{
+			std::lock_guard<std::mutex> lock(mutex); //the waiting thread is either waiting on cv or hasn't checked the state yet
+			cv.notify_one();
+		}
+	}
+
+	//unit of the duration is millisecond, 0 means wait infinitely
+	sync_call_result wait(unsigned duration)
+	{
+		if (DONE == state.load(std::memory_order_acquire))
+			return result;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		int expected = IDLE;
+		if (state.compare_exchange_strong(expected, WAITING, std::memory_order_acq_rel))
+		{
+			auto pred = [this]() {return DONE == this->state.load(std::memory_order_acquire);};
+			if (0 == duration)
+				cv.wait(lock, std::move(pred));
+			else if (!cv.wait_for(lock, std::chrono::milliseconds(duration), std::move(pred)))
+				return sync_call_result::TIMEOUT; //the msg still holds this waiter, so it's safe to be completed later
+		}
+
+		return result;
+	}
+
+private:
+	enum {IDLE, WAITING, DONE};
+
+	sync_call_result result;
+	std::atomic_int state;
+	std::mutex mutex;
+	std::condition_variable cv;
+};
+
+//the waiter of sync msg sending, only the msg holds it (the waiting thread holds its state), so if the msg been freed without completion
+// (a user dropped it in on_msg_shed for example), the waiting thread will still be woken up with NOT_APPLICABLE.
+class sync_send_waiter : public i_send_completion
+{
+public:
+	sync_send_waiter() : state(make_send_completion<sync_send_state>()), done(false) {}
+	~sync_send_waiter() {if (!done) state->complete(sync_call_result::NOT_APPLICABLE);}
+
+	virtual void complete(sync_call_result re) {if (!done) {done = true; state->complete(re);}}
+	const std::shared_ptr<sync_send_state>& get_state() const {return state;}
+
+private:
+	std::shared_ptr<sync_send_state> state;
+	bool done;
+};
+
+typedef std::function<void(sync_call_result)> send_callback;
+class send_callback_completion : public i_send_completion
+{
+public:
+	send_callback_completion(const send_callback& cb_) : cb(cb_) {}
+	~send_callback_completion() {if (cb) cb(sync_call_result::NOT_APPLICABLE);} //the msg been freed without completion
+
+	virtual void complete(sync_call_result re) {if (cb) {send_callback cb_; cb_.swap(cb); cb_(re);}}
+
+private:
+	send_callback cb;
+};
+
+//specify a callback which will be invoked after msgs been sent (or failed) when sending them, without blocking the calling thread,
+// the callback will be invoked in service threads, or in the thread which dropped the msgs (see i_send_completion), or in the thread
+// which freed the msgs without completion (the last resort), so it must not block (and never call sync msg sending in it).
+//the constructor is explicit for the same reason as lane.
+struct completion
+{
+	explicit completion(const send_callback& cb, bool prior_ = false) : p(make_send_completion<send_callback_completion>(cb)), prior(prior_) {}
+	explicit completion(const std::shared_ptr<i_send_completion>& p_, bool prior_ = false) : p(p_), prior(prior_) {}
+
+	std::shared_ptr<i_send_completion> p;
+	bool prior; //put msgs at the front of the send buffer or not
+};
+
 template<typename T> struct obj_with_begin_time_promise : public obj_with_begin_time<T>
 {
 	typedef obj_with_begin_time<T> super;
@@ -493,9 +835,10 @@ template<typename T> struct obj_with_begin_time_promise : public obj_with_begin_
 	void swap(obj_with_begin_time_promise& other) {super::swap(other); p.swap(other.p);}
 
 	void clear() {super::clear(); p.reset();}
-	void check_and_create_promise(bool need_promise) {if (!need_promise) p.reset(); else if (!p) p = std::make_shared<std::promise<sync_call_result>>();}
+	void check_and_create_promise(bool need_promise) {if (!need_promise) p.reset(); else if (!p) p = make_send_completion<sync_send_waiter>();}
+	void complete(sync_call_result re) {if (p) {p->complete(re); p.reset();}} //invoke the completion (if any) only once
 
-	std::shared_ptr<std::promise<sync_call_result>> p;
+	std::shared_ptr<i_send_completion> p;
 };
 #endif
 
@@ -532,6 +875,15 @@ size_t get_size_in_byte(const _Can& __can, size_t& size)
 	return size_in_byte;
 }
 
+//complete msgs which carry completions (see obj_with_begin_time_promise) with NOT_APPLICABLE, containers call it before dropping msgs,
+// other items are just left untouched.
+template<typename _Item> auto complete_dropped_item(_Item& item, int) -> decltype(item.complete(sync_call_result::NOT_APPLICABLE))
+	{return item.complete(sync_call_result::NOT_APPLICABLE);}
+template<typename _Item> void complete_dropped_item(_Item& item, long) {}
+
+template<typename _Can>
+void complete_dropped_items(_Can& __can) {do_something_to_all(__can, [](typename _Can::reference item) {complete_dropped_item(item, 0);});}
+
 //member functions, used to do something to any member container(except map and multimap) optionally with any member mutex
 #define DO_SOMETHING_TO_ALL_MUTEX(CAN, MUTEX) DO_SOMETHING_TO_ALL_MUTEX_NAME(do_something_to_all, CAN, MUTEX)
 #define DO_SOMETHING_TO_ALL(CAN) DO_SOMETHING_TO_ALL_NAME(do_something_to_all, CAN)
@@ -558,27 +910,82 @@ template<typename _Predicate> void NAME(const _Predicate& __pred) const {for (au
 #define SAFE_SEND_MSG_CHECK(F_VALUE) \
 { \
 	if (!is_ready()) return F_VALUE; \
-	std::this_thread::sleep_for(std::chrono::milliseconds(50)); \
+	this->wait_send_buffer_available(50); /*the memory governor never wakes us up, so check is_ready and retry every 50 milliseconds*/ \
 }
 
 #define GET_PENDING_MSG_SIZE(FUNNAME, CAN) size_t FUNNAME() const {return CAN.size_in_byte();}
 #define POP_FIRST_PENDING_MSG(FUNNAME, CAN, MSGTYPE) void FUNNAME(MSGTYPE& msg) {msg.clear(); CAN.try_dequeue(msg);}
 #define POP_FIRST_PENDING_MSG_NOTIFY(FUNNAME, CAN, MSGTYPE) void FUNNAME(MSGTYPE& msg) \
-	{msg.clear(); if (CAN.try_dequeue(msg) && msg.p) msg.p->set_value(sync_call_result::NOT_APPLICABLE);}
+	{msg.clear(); if (CAN.try_dequeue(msg)) msg.complete(sync_call_result::NOT_APPLICABLE);}
 #define POP_ALL_PENDING_MSG(FUNNAME, CAN, CANTYPE) void FUNNAME(CANTYPE& can) {can.clear(); CAN.swap(can);}
 #define POP_ALL_PENDING_MSG_NOTIFY(FUNNAME, CAN, CANTYPE) void FUNNAME(CANTYPE& can) \
-	{can.clear(); CAN.swap(can); ascs::do_something_to_all(can, [](typename CANTYPE::reference msg) {if (msg.p) msg.p->set_value(sync_call_result::NOT_APPLICABLE);});}
+	{can.clear(); CAN.swap(can); ascs::do_something_to_all(can, [](typename CANTYPE::reference msg) {msg.complete(sync_call_result::NOT_APPLICABLE);});}
+
+//the trailing parameters of msg sending interfaces, each interface has two versions, one takes 'bool prior' (put msgs at the front of
+// the send buffer), the other one takes 'const lane& prior' (put msgs into the specified lane, only works with multi_lane_queue).
+//they're function-like macros so they can be passed to other macros without being expanded (and then break the arguments by comma).
+#define ASCS_PRIOR_PARAM() bool can_overflow = false, bool prior = false
+#define ASCS_PRIOR_ARG() can_overflow, prior
+#define ASCS_LANE_PARAM() const lane& prior, bool can_overflow = false
+#define ASCS_LANE_ARG() prior, can_overflow
+#define ASCS_SYNC_PRIOR_PARAM() unsigned duration = 0, bool can_overflow = false, bool prior = false
+#define ASCS_SYNC_PRIOR_ARG() duration, can_overflow, prior
+#define ASCS_SYNC_LANE_PARAM() const lane& prior, unsigned duration = 0, bool can_overflow = false
+#define ASCS_SYNC_LANE_ARG() prior, duration, can_overflow
+#define ASCS_PARALLEL_PRIOR_PARAM() float max_usage = 0.f, bool can_overflow = false, bool prior = false
+#define ASCS_PARALLEL_PRIOR_ARG() max_usage, can_overflow, prior
+#define ASCS_PARALLEL_LANE_PARAM() const lane& prior, float max_usage = 0.f, bool can_overflow = false
+#define ASCS_PARALLEL_LANE_ARG() prior, max_usage, can_overflow
+//with macro ASCS_MSG_DEADLINE, msg sending interfaces (except sync and parallel ones) have a third version, which takes 'const deadline& prior'.
+#ifdef ASCS_MSG_DEADLINE
+#define ASCS_DEADLINE_PARAM() const deadline& prior, bool can_overflow = false
+#define ASCS_DEADLINE_ARG() prior, can_overflow
+#define ASCS_DEADLINE_VERSION(IMPL, NAME, ARG2) IMPL(NAME, ARG2, ASCS_DEADLINE_PARAM, ASCS_DEADLINE_ARG)
+#else
+#define ASCS_DEADLINE_VERSION(IMPL, NAME, ARG2)
+#endif
+//with macro ASCS_SYNC_SEND, msg sending interfaces (except broadcast, sync and parallel ones) have a version which takes 'const completion& prior'.
+#ifdef ASCS_SYNC_SEND
+#define ASCS_COMPLETION_PARAM() const completion& prior, bool can_overflow = false
+#define ASCS_COMPLETION_ARG() prior, can_overflow
+#define ASCS_COMPLETION_VERSION(IMPL, NAME, ARG2) IMPL(NAME, ARG2, ASCS_COMPLETION_PARAM, ASCS_COMPLETION_ARG)
+#else
+#define ASCS_COMPLETION_VERSION(IMPL, NAME, ARG2)
+#endif
+//with macro ASCS_COROUTINE, msg sending interfaces (send_msg, send_native_msg and direct_send_msg) have an awaitable version, which takes
+// msgs only (can_overflow is always true), it returns the result of the completion (see above). msgs are decay-copied (or moved) into
+// the awaitable, so it can outlive them, but pointers (const char* for example) still need to be valid until the awaitable been awaited.
+//the safe version (of send_msg and send_native_msg) doesn't overflow the sending buffer, the coroutine will be suspended until the buffer
+// becomes available (see ascs::socket::co_safe_send_msg).
+#ifdef ASCS_COROUTINE
+#define ASCS_CO_SEND_MSG(FUNNAME, SEND_FUNNAME) \
+template<typename... Args> auto FUNNAME(Args&&... args) \
+	{return this->co_send_msg([this, ...args = std::forward<Args>(args)](const completion& c) mutable {return this->SEND_FUNNAME(std::move(args)..., c, true);});}
+#define ASCS_CO_SAFE_SEND_MSG(FUNNAME, SEND_FUNNAME) \
+template<typename... Args> auto FUNNAME(Args&&... args) \
+	{return this->co_safe_send_msg([this, ...args = std::forward<Args>(args)](const completion& c) mutable {return this->SEND_FUNNAME(std::move(args)..., c, true);});}
+#else
+#define ASCS_CO_SEND_MSG(FUNNAME, SEND_FUNNAME)
+#define ASCS_CO_SAFE_SEND_MSG(FUNNAME, SEND_FUNNAME)
+#endif
 
 ///////////////////////////////////////////////////
 //TCP msg sending interface
-#define TCP_SEND_MSG_CALL_SWITCH(FUNNAME, TYPE) \
-TYPE FUNNAME(const char* pstr, size_t len, bool can_overflow = false, bool prior = false) {return FUNNAME(&pstr, &len, 1, can_overflow, prior);} \
-TYPE FUNNAME(char* pstr, size_t len, bool can_overflow = false, bool prior = false) {return FUNNAME(&pstr, &len, 1, can_overflow, prior);} \
+//xxx_CALL_SWITCH only generate the 'bool prior' version, use xxx_CALL_SWITCH_IMPL to generate the 'const lane& prior' version.
+#define TCP_SEND_MSG_CALL_SWITCH(FUNNAME, TYPE) TCP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, TYPE, ASCS_PRIOR_PARAM, ASCS_PRIOR_ARG)
+#define TCP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, TYPE, PARAM, ARG) \
+TYPE FUNNAME(const char* pstr, size_t len, PARAM()) {return FUNNAME(&pstr, &len, 1, ARG());} \
+TYPE FUNNAME(char* pstr, size_t len, PARAM()) {return FUNNAME(&pstr, &len, 1, ARG());} \
 template<typename Buffer> \
-TYPE FUNNAME(const Buffer& buffer, bool can_overflow = false, bool prior = false) {return FUNNAME(buffer.data(), buffer.size(), can_overflow, prior);}
+TYPE FUNNAME(const Buffer& buffer, PARAM()) {return FUNNAME(buffer.data(), buffer.size(), ARG());}
 
 #define TCP_SEND_MSG(FUNNAME, NATIVE) \
-bool FUNNAME(in_msg_type&& msg, bool can_overflow = false, bool prior = false) \
+TCP_SEND_MSG_IMPL(FUNNAME, NATIVE, ASCS_PRIOR_PARAM, ASCS_PRIOR_ARG) \
+TCP_SEND_MSG_IMPL(FUNNAME, NATIVE, ASCS_LANE_PARAM, ASCS_LANE_ARG) \
+ASCS_DEADLINE_VERSION(TCP_SEND_MSG_IMPL, FUNNAME, NATIVE) \
+ASCS_COMPLETION_VERSION(TCP_SEND_MSG_IMPL, FUNNAME, NATIVE)
+#define TCP_SEND_MSG_IMPL(FUNNAME, NATIVE, PARAM, ARG) \
+bool FUNNAME(in_msg_type&& msg, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return false; \
@@ -590,7 +997,7 @@ bool FUNNAME(in_msg_type&& msg, bool can_overflow = false, bool prior = false) \
 	dur.end(); \
 	return re && do_direct_send_msg(msg_can, prior); \
 } \
-bool FUNNAME(in_msg_ctype& msg, bool can_overflow = false, bool prior = false) \
+bool FUNNAME(in_msg_ctype& msg, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return false; \
@@ -602,7 +1009,7 @@ bool FUNNAME(in_msg_ctype& msg, bool can_overflow = false, bool prior = false) \
 	dur.end(); \
 	return re && do_direct_send_msg(msg_can, prior); \
 } \
-bool FUNNAME(in_msg_type&& msg1, in_msg_type&& msg2, bool can_overflow = false, bool prior = false) \
+bool FUNNAME(in_msg_type&& msg1, in_msg_type&& msg2, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return false; \
@@ -617,7 +1024,7 @@ bool FUNNAME(in_msg_type&& msg1, in_msg_type&& msg2, bool can_overflow = false,
 	dur.end(); \
 	return re && do_direct_send_msg(msg_can, prior); \
 } \
-bool FUNNAME(in_msg_ctype& msg1, in_msg_ctype& msg2, bool can_overflow = false, bool prior = false) \
+bool FUNNAME(in_msg_ctype& msg1, in_msg_ctype& msg2, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return false; \
@@ -632,7 +1039,7 @@ bool FUNNAME(in_msg_ctype& msg1, in_msg_ctype& msg2, bool can_overflow = false,
 	dur.end(); \
 	return re && do_direct_send_msg(msg_can, prior); \
 } \
-bool FUNNAME(typename Packer::container_type& msg_can, bool can_overflow = false, bool prior = false) \
+bool FUNNAME(typename Packer::container_type& msg_can, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return false; \
@@ -644,7 +1051,7 @@ bool FUNNAME(typename Packer::container_type& msg_can, bool can_overflow = false
 	dur.end(); \
 	return re && do_direct_send_msg(out, prior); \
 } \
-bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, bool can_overflow = false, bool prior = false) \
+bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return false; \
@@ -653,49 +1060,106 @@ bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, bool can_
 	dur.end(); \
 	return do_direct_send_msg(std::move(msg), prior); \
 } \
-TCP_SEND_MSG_CALL_SWITCH(FUNNAME, bool)
+TCP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, bool, PARAM, ARG)
 
 //guarantee send msg successfully even if can_overflow equal to false, success at here just means putting the msg into tcp::socket_base's send buffer successfully
 //if can_overflow equal to false and the buffer is not available, will wait until it becomes available
 #define TCP_SAFE_SEND_MSG(FUNNAME, SEND_FUNNAME) \
-bool FUNNAME(in_msg_type&& msg, bool can_overflow = false, bool prior = false) \
-	{while (!SEND_FUNNAME(std::move(msg), can_overflow, prior)) SAFE_SEND_MSG_CHECK(false) return true;} \
-bool FUNNAME(in_msg_ctype& msg, bool can_overflow = false, bool prior = false) \
-	{while (!SEND_FUNNAME(msg, can_overflow, prior)) SAFE_SEND_MSG_CHECK(false) return true;} \
-bool FUNNAME(in_msg_type&& msg1, in_msg_type&& msg2, bool can_overflow = false, bool prior = false) \
-	{while (!SEND_FUNNAME(std::move(msg1), std::move(msg2), can_overflow, prior)) SAFE_SEND_MSG_CHECK(false) return true;} \
-bool FUNNAME(in_msg_ctype& msg1, in_msg_ctype& msg2, bool can_overflow = false, bool prior = false) \
-	{while (!SEND_FUNNAME(msg1, msg2, can_overflow, prior)) SAFE_SEND_MSG_CHECK(false) return true;} \
-bool FUNNAME(typename Packer::container_type& msg_can, bool can_overflow = false, bool prior = false) \
-	{while (!SEND_FUNNAME(msg_can, can_overflow, prior)) SAFE_SEND_MSG_CHECK(false) return true;} \
-bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, bool can_overflow = false, bool prior = false) \
-	{while (!SEND_FUNNAME(pstr, len, num, can_overflow, prior)) SAFE_SEND_MSG_CHECK(false) return true;} \
-TCP_SEND_MSG_CALL_SWITCH(FUNNAME, bool)
+TCP_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, ASCS_PRIOR_PARAM, ASCS_PRIOR_ARG) \
+TCP_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, ASCS_LANE_PARAM, ASCS_LANE_ARG) \
+ASCS_DEADLINE_VERSION(TCP_SAFE_SEND_MSG_IMPL, FUNNAME, SEND_FUNNAME) \
+ASCS_COMPLETION_VERSION(TCP_SAFE_SEND_MSG_IMPL, FUNNAME, SEND_FUNNAME)
+#define TCP_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, PARAM, ARG) \
+bool FUNNAME(in_msg_type&& msg, PARAM()) \
+	{while (!SEND_FUNNAME(std::move(msg), ARG())) SAFE_SEND_MSG_CHECK(false) return true;} \
+bool FUNNAME(in_msg_ctype& msg, PARAM()) \
+	{while (!SEND_FUNNAME(msg, ARG())) SAFE_SEND_MSG_CHECK(false) return true;} \
+bool FUNNAME(in_msg_type&& msg1, in_msg_type&& msg2, PARAM()) \
+	{while (!SEND_FUNNAME(std::move(msg1), std::move(msg2), ARG())) SAFE_SEND_MSG_CHECK(false) return true;} \
+bool FUNNAME(in_msg_ctype& msg1, in_msg_ctype& msg2, PARAM()) \
+	{while (!SEND_FUNNAME(msg1, msg2, ARG())) SAFE_SEND_MSG_CHECK(false) return true;} \
+bool FUNNAME(typename Packer::container_type& msg_can, PARAM()) \
+	{while (!SEND_FUNNAME(msg_can, ARG())) SAFE_SEND_MSG_CHECK(false) return true;} \
+bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+	{while (!SEND_FUNNAME(pstr, len, num, ARG())) SAFE_SEND_MSG_CHECK(false) return true;} \
+TCP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, bool, PARAM, ARG)
 
 #define TCP_BROADCAST_MSG(FUNNAME, SEND_FUNNAME) \
-void FUNNAME(typename Pool::in_msg_ctype& msg, bool can_overflow = false, bool prior = false) \
-	{this->do_something_to_all([&](typename Pool::object_ctype& item) {item->SEND_FUNNAME(msg, can_overflow, prior);});} \
-void FUNNAME(typename Pool::in_msg_ctype& msg1, typename Pool::in_msg_ctype& msg2, bool can_overflow = false, bool prior = false) \
-	{this->do_something_to_all([&](typename Pool::object_ctype& item) {item->SEND_FUNNAME(msg1, msg2, can_overflow, prior);});} \
-void FUNNAME(const char* const pstr[], const size_t len[], size_t num, bool can_overflow = false, bool prior = false) \
-	{this->do_something_to_all([&](typename Pool::object_ctype& item) {item->SEND_FUNNAME(pstr, len, num, can_overflow, prior);});} \
-TCP_SEND_MSG_CALL_SWITCH(FUNNAME, void)
+TCP_BROADCAST_MSG_IMPL(FUNNAME, SEND_FUNNAME, ASCS_PRIOR_PARAM, ASCS_PRIOR_ARG) \
+TCP_BROADCAST_MSG_IMPL(FUNNAME, SEND_FUNNAME, ASCS_LANE_PARAM, ASCS_LANE_ARG) \
+ASCS_DEADLINE_VERSION(TCP_BROADCAST_MSG_IMPL, FUNNAME, SEND_FUNNAME)
+#define TCP_BROADCAST_MSG_IMPL(FUNNAME, SEND_FUNNAME, PARAM, ARG) \
+void FUNNAME(typename Pool::in_msg_ctype& msg, PARAM()) \
+	{this->do_something_to_all([&](typename Pool::object_ctype& item) {item->SEND_FUNNAME(msg, ARG());});} \
+void FUNNAME(typename Pool::in_msg_ctype& msg1, typename Pool::in_msg_ctype& msg2, PARAM()) \
+	{this->do_something_to_all([&](typename Pool::object_ctype& item) {item->SEND_FUNNAME(msg1, msg2, ARG());});} \
+void FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+	{this->do_something_to_all([&](typename Pool::object_ctype& item) {item->SEND_FUNNAME(pstr, len, num, ARG());});} \
+TCP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, void, PARAM, ARG)
+
+//pack the message only once (by a new Pool::packer_type, so all sockets must use the same type of packer), then put it into all sockets'
+// send buffer directly (via direct_send_msg), if the packer's msg_type is reference-counted (like ext::shared_packer), all sockets share
+// the same bytes, which will be freed after the last socket finished sending them, otherwise, the packed message will be copied for each socket.
+#define TCP_SHARED_BROADCAST_MSG(FUNNAME, NATIVE) \
+TCP_SHARED_BROADCAST_MSG_IMPL(FUNNAME, NATIVE, ASCS_PRIOR_PARAM, ASCS_PRIOR_ARG) \
+TCP_SHARED_BROADCAST_MSG_IMPL(FUNNAME, NATIVE, ASCS_LANE_PARAM, ASCS_LANE_ARG) \
+ASCS_DEADLINE_VERSION(TCP_SHARED_BROADCAST_MSG_IMPL, FUNNAME, NATIVE)
+#define TCP_SHARED_BROADCAST_MSG_IMPL(FUNNAME, NATIVE, PARAM, ARG) \
+void FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+{ \
+	const auto msg = typename Pool::packer_type().pack_msg(pstr, len, num, NATIVE); \
+	if (!msg.empty()) \
+		this->do_something_to_all([&](typename Pool::object_ctype& item) {item->direct_send_msg(msg, ARG());}); \
+} \
+TCP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, void, PARAM, ARG)
+
+//like TCP_SHARED_BROADCAST_MSG, but sockets are handled in service threads concurrently (see object_pool::parallel_do_something_to_all),
+//handler will be invoked after all sockets been handled, chunk_statistic::affected_num is the number of sockets which accepted the message.
+//sockets whose send_buf_usage() is above max_usage will be skipped (0 means no limitation).
+//please note that successive parallel broadcastings may put their messages into the same socket out of order (because chunks of them can
+// be handled concurrently), if the order matters, start the next one after the handler of the previous one been invoked.
+#define TCP_PARALLEL_BROADCAST_MSG(FUNNAME, NATIVE) \
+TCP_PARALLEL_BROADCAST_MSG_IMPL(FUNNAME, NATIVE, ASCS_PARALLEL_PRIOR_PARAM, ASCS_PARALLEL_PRIOR_ARG, ASCS_PRIOR_ARG) \
+TCP_PARALLEL_BROADCAST_MSG_IMPL(FUNNAME, NATIVE, ASCS_PARALLEL_LANE_PARAM, ASCS_PARALLEL_LANE_ARG, ASCS_LANE_ARG)
+#define TCP_PARALLEL_BROADCAST_MSG_IMPL(FUNNAME, NATIVE, PARAM, ARG, SEND_ARG) \
+void FUNNAME(const char* const pstr[], const size_t len[], size_t num, const typename Pool::parallel_handler& handler, PARAM()) \
+{ \
+	const auto msg = typename Pool::packer_type().pack_msg(pstr, len, num, NATIVE); \
+	if (msg.empty()) \
+	{ \
+		if (handler) \
+			handler(std::vector<typename Pool::chunk_statistic>()); \
+	} \
+	else \
+		this->parallel_do_something_to_all([=](typename Pool::object_ctype& item) \
+			{return (max_usage <= 0.f || item->send_buf_usage() <= max_usage) && item->direct_send_msg(msg, SEND_ARG());}, handler); \
+} \
+void FUNNAME(const char* pstr, size_t len, const typename Pool::parallel_handler& handler, PARAM()) \
+	{FUNNAME(&pstr, &len, 1, handler, ARG());} \
+void FUNNAME(char* pstr, size_t len, const typename Pool::parallel_handler& handler, PARAM()) \
+	{FUNNAME(&pstr, &len, 1, handler, ARG());} \
+template<typename Buffer> void FUNNAME(const Buffer& buffer, const typename Pool::parallel_handler& handler, PARAM()) \
+	{FUNNAME(buffer.data(), buffer.size(), handler, ARG());}
 //TCP msg sending interface
 ///////////////////////////////////////////////////
 
 #ifdef ASCS_SYNC_SEND
 ///////////////////////////////////////////////////
 //TCP sync msg sending interface
-#define TCP_SYNC_SEND_MSG_CALL_SWITCH(FUNNAME, TYPE) \
-TYPE FUNNAME(const char* pstr, size_t len, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(&pstr, &len, 1, duration, can_overflow, prior);} \
-TYPE FUNNAME(char* pstr, size_t len, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(&pstr, &len, 1, duration, can_overflow, prior);} \
-template<typename Buffer> TYPE FUNNAME(const Buffer& buffer, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(buffer.data(), buffer.size(), duration, can_overflow, prior);}
+#define TCP_SYNC_SEND_MSG_CALL_SWITCH(FUNNAME, TYPE) TCP_SYNC_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, TYPE, ASCS_SYNC_PRIOR_PARAM, ASCS_SYNC_PRIOR_ARG)
+#define TCP_SYNC_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, TYPE, PARAM, ARG) \
+TYPE FUNNAME(const char* pstr, size_t len, PARAM()) \
+	{return FUNNAME(&pstr, &len, 1, ARG());} \
+TYPE FUNNAME(char* pstr, size_t len, PARAM()) \
+	{return FUNNAME(&pstr, &len, 1, ARG());} \
+template<typename Buffer> TYPE FUNNAME(const Buffer& buffer, PARAM()) \
+	{return FUNNAME(buffer.data(), buffer.size(), ARG());}
 
 #define TCP_SYNC_SEND_MSG(FUNNAME, NATIVE) \
-sync_call_result FUNNAME(in_msg_type&& msg, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
+TCP_SYNC_SEND_MSG_IMPL(FUNNAME, NATIVE, ASCS_SYNC_PRIOR_PARAM, ASCS_SYNC_PRIOR_ARG) \
+TCP_SYNC_SEND_MSG_IMPL(FUNNAME, NATIVE, ASCS_SYNC_LANE_PARAM, ASCS_SYNC_LANE_ARG)
+#define TCP_SYNC_SEND_MSG_IMPL(FUNNAME, NATIVE, PARAM, ARG) \
+sync_call_result FUNNAME(in_msg_type&& msg, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return sync_call_result::NOT_APPLICABLE; \
@@ -707,7 +1171,7 @@ sync_call_result FUNNAME(in_msg_type&& msg, unsigned duration = 0, bool can_over
 	dur.end(); \
 	return re ? do_direct_sync_send_msg(msg_can, duration, prior) : sync_call_result::NOT_APPLICABLE; \
 } \
-sync_call_result FUNNAME(in_msg_ctype& msg, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
+sync_call_result FUNNAME(in_msg_ctype& msg, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return sync_call_result::NOT_APPLICABLE; \
@@ -719,7 +1183,7 @@ sync_call_result FUNNAME(in_msg_ctype& msg, unsigned duration = 0, bool can_over
 	dur.end(); \
 	return re ? do_direct_sync_send_msg(msg_can, duration, prior) : sync_call_result::NOT_APPLICABLE; \
 } \
-sync_call_result FUNNAME(in_msg_type&& msg1, in_msg_type&& msg2, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
+sync_call_result FUNNAME(in_msg_type&& msg1, in_msg_type&& msg2, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return sync_call_result::NOT_APPLICABLE; \
@@ -734,7 +1198,7 @@ sync_call_result FUNNAME(in_msg_type&& msg1, in_msg_type&& msg2, unsigned durati
 	dur.end(); \
 	return re ? do_direct_sync_send_msg(msg_can, duration, prior) : sync_call_result::NOT_APPLICABLE; \
 } \
-sync_call_result FUNNAME(in_msg_ctype& msg1, in_msg_ctype& msg2, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
+sync_call_result FUNNAME(in_msg_ctype& msg1, in_msg_ctype& msg2, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return sync_call_result::NOT_APPLICABLE; \
@@ -749,7 +1213,7 @@ sync_call_result FUNNAME(in_msg_ctype& msg1, in_msg_ctype& msg2, unsigned durati
 	dur.end(); \
 	return re ? do_direct_sync_send_msg(msg_can, duration, prior) : sync_call_result::NOT_APPLICABLE; \
 } \
-sync_call_result FUNNAME(typename Packer::container_type& msg_can, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
+sync_call_result FUNNAME(typename Packer::container_type& msg_can, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return sync_call_result::NOT_APPLICABLE; \
@@ -761,7 +1225,7 @@ sync_call_result FUNNAME(typename Packer::container_type& msg_can, unsigned dura
 	dur.end(); \
 	return re ? do_direct_sync_send_msg(out, duration, prior) : sync_call_result::NOT_APPLICABLE; \
 } \
-sync_call_result FUNNAME(const char* const pstr[], const size_t len[], size_t num, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
+sync_call_result FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return sync_call_result::NOT_APPLICABLE; \
@@ -770,111 +1234,147 @@ sync_call_result FUNNAME(const char* const pstr[], const size_t len[], size_t nu
 	dur.end(); \
 	return do_direct_sync_send_msg(std::move(msg), duration, prior); \
 } \
-TCP_SYNC_SEND_MSG_CALL_SWITCH(FUNNAME, sync_call_result)
+TCP_SYNC_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, sync_call_result, PARAM, ARG)
 
 //guarantee send msg successfully even if can_overflow equal to false, success at here just means putting the msg into tcp::socket_base's send buffer successfully
 //if can_overflow equal to false and the buffer is not available, will wait until it becomes available
 #define TCP_SYNC_SAFE_SEND_MSG(FUNNAME, SEND_FUNNAME) \
-sync_call_result FUNNAME(in_msg_type&& msg, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{while (sync_call_result::SUCCESS != SEND_FUNNAME(std::move(msg), duration, can_overflow, prior)) \
+TCP_SYNC_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, ASCS_SYNC_PRIOR_PARAM, ASCS_SYNC_PRIOR_ARG) \
+TCP_SYNC_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, ASCS_SYNC_LANE_PARAM, ASCS_SYNC_LANE_ARG)
+#define TCP_SYNC_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, PARAM, ARG) \
+sync_call_result FUNNAME(in_msg_type&& msg, PARAM()) \
+	{while (sync_call_result::SUCCESS != SEND_FUNNAME(std::move(msg), ARG())) \
 		SAFE_SEND_MSG_CHECK(sync_call_result::NOT_APPLICABLE) return sync_call_result::SUCCESS;} \
-sync_call_result FUNNAME(in_msg_ctype& msg, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{while (sync_call_result::SUCCESS != SEND_FUNNAME(msg, duration, can_overflow, prior)) \
+sync_call_result FUNNAME(in_msg_ctype& msg, PARAM()) \
+	{while (sync_call_result::SUCCESS != SEND_FUNNAME(msg, ARG())) \
 		SAFE_SEND_MSG_CHECK(sync_call_result::NOT_APPLICABLE) return sync_call_result::SUCCESS;} \
-sync_call_result FUNNAME(in_msg_type&& msg1, in_msg_type&& msg2, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{while (sync_call_result::SUCCESS != SEND_FUNNAME(std::move(msg1), std::move(msg2), duration, can_overflow, prior)) \
+sync_call_result FUNNAME(in_msg_type&& msg1, in_msg_type&& msg2, PARAM()) \
+	{while (sync_call_result::SUCCESS != SEND_FUNNAME(std::move(msg1), std::move(msg2), ARG())) \
 		SAFE_SEND_MSG_CHECK(sync_call_result::NOT_APPLICABLE) return sync_call_result::SUCCESS;} \
-sync_call_result FUNNAME(in_msg_ctype& msg1, in_msg_ctype& msg2, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{while (sync_call_result::SUCCESS != SEND_FUNNAME(msg1, msg2, duration, can_overflow, prior)) \
+sync_call_result FUNNAME(in_msg_ctype& msg1, in_msg_ctype& msg2, PARAM()) \
+	{while (sync_call_result::SUCCESS != SEND_FUNNAME(msg1, msg2, ARG())) \
 		SAFE_SEND_MSG_CHECK(sync_call_result::NOT_APPLICABLE) return sync_call_result::SUCCESS;} \
-sync_call_result FUNNAME(typename Packer::container_type& msg_can, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{while (sync_call_result::SUCCESS != SEND_FUNNAME(msg_can, duration, can_overflow, prior)) \
+sync_call_result FUNNAME(typename Packer::container_type& msg_can, PARAM()) \
+	{while (sync_call_result::SUCCESS != SEND_FUNNAME(msg_can, ARG())) \
 		SAFE_SEND_MSG_CHECK(sync_call_result::NOT_APPLICABLE) return sync_call_result::SUCCESS;} \
-sync_call_result FUNNAME(const char* const pstr[], const size_t len[], size_t num, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{while (sync_call_result::SUCCESS != SEND_FUNNAME(pstr, len, num, duration, can_overflow, prior)) \
+sync_call_result FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+	{while (sync_call_result::SUCCESS != SEND_FUNNAME(pstr, len, num, ARG())) \
 		SAFE_SEND_MSG_CHECK(sync_call_result::NOT_APPLICABLE) return sync_call_result::SUCCESS;} \
-TCP_SYNC_SEND_MSG_CALL_SWITCH(FUNNAME, sync_call_result)
+TCP_SYNC_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, sync_call_result, PARAM, ARG)
 //TCP sync msg sending interface
 ///////////////////////////////////////////////////
 #endif
 
 ///////////////////////////////////////////////////
 //UDP msg sending interface
-#define UDP_SEND_MSG_CALL_SWITCH(FUNNAME, TYPE) \
-TYPE FUNNAME(const char* pstr, size_t len, bool can_overflow = false, bool prior = false) {return FUNNAME(peer_addr, pstr, len, can_overflow, prior);} \
-TYPE FUNNAME(char* pstr, size_t len, bool can_overflow = false, bool prior = false) {return FUNNAME(peer_addr, pstr, len, can_overflow, prior);} \
-TYPE FUNNAME(const typename Family::endpoint& peer_addr, const char* pstr, size_t len, bool can_overflow = false, bool prior = false) \
-    {return FUNNAME(peer_addr, &pstr, &len, 1, can_overflow, prior);} \
-TYPE FUNNAME(const typename Family::endpoint& peer_addr, char* pstr, size_t len, bool can_overflow = false, bool prior = false) \
-    {return FUNNAME(peer_addr, &pstr, &len, 1, can_overflow, prior);} \
-template<typename Buffer> TYPE FUNNAME(const Buffer& buffer, bool can_overflow = false, bool prior = false) {return FUNNAME(peer_addr, buffer, can_overflow, prior);} \
-template<typename Buffer> TYPE FUNNAME(const typename Family::endpoint& peer_addr, const Buffer& buffer, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, buffer.data(), buffer.size(), can_overflow, prior);}
+#define UDP_SEND_MSG_CALL_SWITCH(FUNNAME, TYPE) UDP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, TYPE, ASCS_PRIOR_PARAM, ASCS_PRIOR_ARG)
+#define UDP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, TYPE, PARAM, ARG) \
+TYPE FUNNAME(const char* pstr, size_t len, PARAM()) {return FUNNAME(peer_addr, pstr, len, ARG());} \
+TYPE FUNNAME(char* pstr, size_t len, PARAM()) {return FUNNAME(peer_addr, pstr, len, ARG());} \
+TYPE FUNNAME(const typename Family::endpoint& peer_addr, const char* pstr, size_t len, PARAM()) \
+    {return FUNNAME(peer_addr, &pstr, &len, 1, ARG());} \
+TYPE FUNNAME(const typename Family::endpoint& peer_addr, char* pstr, size_t len, PARAM()) \
+    {return FUNNAME(peer_addr, &pstr, &len, 1, ARG());} \
+template<typename Buffer> TYPE FUNNAME(const Buffer& buffer, PARAM()) {return FUNNAME(peer_addr, buffer, ARG());} \
+template<typename Buffer> TYPE FUNNAME(const typename Family::endpoint& peer_addr, const Buffer& buffer, PARAM()) \
+	{return FUNNAME(peer_addr, buffer.data(), buffer.size(), ARG());}
 
 #define UDP_SEND_MSG(FUNNAME, NATIVE) \
-bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, pstr, len, num, can_overflow, prior);} \
-bool FUNNAME(const typename Family::endpoint& peer_addr, const char* const pstr[], const size_t len[], size_t num, bool can_overflow = false, bool prior = false) \
+UDP_SEND_MSG_IMPL(FUNNAME, NATIVE, ASCS_PRIOR_PARAM, ASCS_PRIOR_ARG) \
+UDP_SEND_MSG_IMPL(FUNNAME, NATIVE, ASCS_LANE_PARAM, ASCS_LANE_ARG) \
+ASCS_DEADLINE_VERSION(UDP_SEND_MSG_IMPL, FUNNAME, NATIVE) \
+ASCS_COMPLETION_VERSION(UDP_SEND_MSG_IMPL, FUNNAME, NATIVE)
+#define UDP_SEND_MSG_IMPL(FUNNAME, NATIVE, PARAM, ARG) \
+bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+	{return FUNNAME(peer_addr, pstr, len, num, ARG());} \
+bool FUNNAME(const typename Family::endpoint& peer_addr, const char* const pstr[], const size_t len[], size_t num, PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return false; \
 	in_msg_type msg(peer_addr, this->packer()->pack_msg(pstr, len, num, NATIVE)); \
 	return do_direct_send_msg(std::move(msg), prior); \
 } \
-UDP_SEND_MSG_CALL_SWITCH(FUNNAME, bool)
+UDP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, bool, PARAM, ARG)
 
 //guarantee send msg successfully even if can_overflow equal to false, success at here just means putting the msg into udp::socket_base's send buffer successfully
 //if can_overflow equal to false and the buffer is not available, will wait until it becomes available
 #define UDP_SAFE_SEND_MSG(FUNNAME, SEND_FUNNAME) \
-bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, pstr, len, num, can_overflow, prior);} \
-bool FUNNAME(const typename Family::endpoint& peer_addr, const char* const pstr[], const size_t len[], size_t num, bool can_overflow = false, bool prior = false) \
-	{while (!SEND_FUNNAME(peer_addr, pstr, len, num, can_overflow, prior)) SAFE_SEND_MSG_CHECK(false) return true;} \
-UDP_SEND_MSG_CALL_SWITCH(FUNNAME, bool)
+UDP_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, ASCS_PRIOR_PARAM, ASCS_PRIOR_ARG) \
+UDP_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, ASCS_LANE_PARAM, ASCS_LANE_ARG) \
+ASCS_DEADLINE_VERSION(UDP_SAFE_SEND_MSG_IMPL, FUNNAME, SEND_FUNNAME) \
+ASCS_COMPLETION_VERSION(UDP_SAFE_SEND_MSG_IMPL, FUNNAME, SEND_FUNNAME)
+#define UDP_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, PARAM, ARG) \
+bool FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+	{return FUNNAME(peer_addr, pstr, len, num, ARG());} \
+bool FUNNAME(const typename Family::endpoint& peer_addr, const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+	{while (!SEND_FUNNAME(peer_addr, pstr, len, num, ARG())) SAFE_SEND_MSG_CHECK(false) return true;} \
+UDP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, bool, PARAM, ARG)
+
+//like TCP_SHARED_BROADCAST_MSG, send to each socket's peer address.
+#define UDP_SHARED_BROADCAST_MSG(FUNNAME, NATIVE) \
+UDP_SHARED_BROADCAST_MSG_IMPL(FUNNAME, NATIVE, ASCS_PRIOR_PARAM, ASCS_PRIOR_ARG) \
+UDP_SHARED_BROADCAST_MSG_IMPL(FUNNAME, NATIVE, ASCS_LANE_PARAM, ASCS_LANE_ARG) \
+ASCS_DEADLINE_VERSION(UDP_SHARED_BROADCAST_MSG_IMPL, FUNNAME, NATIVE)
+#define UDP_SHARED_BROADCAST_MSG_IMPL(FUNNAME, NATIVE, PARAM, ARG) \
+void FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+{ \
+	const auto msg = typename Pool::packer_type().pack_msg(pstr, len, num, NATIVE); \
+	if (!msg.empty()) \
+		this->do_something_to_all([&](typename Pool::object_ctype& item) \
+			{item->direct_send_msg(typename Pool::in_msg_type(item->get_peer_addr(), msg), ARG());}); \
+} \
+TCP_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, void, PARAM, ARG)
 //UDP msg sending interface
 ///////////////////////////////////////////////////
 
 #ifdef ASCS_SYNC_SEND
 ///////////////////////////////////////////////////
 //UDP sync msg sending interface
-#define UDP_SYNC_SEND_MSG_CALL_SWITCH(FUNNAME, TYPE) \
-TYPE FUNNAME(const char* pstr, size_t len, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, pstr, len, duration, can_overflow, prior);} \
-TYPE FUNNAME(char* pstr, size_t len, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, pstr, len, duration, can_overflow, prior);} \
-TYPE FUNNAME(const typename Family::endpoint& peer_addr, const char* pstr, size_t len, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, &pstr, &len, 1, duration, can_overflow, prior);} \
-TYPE FUNNAME(const typename Family::endpoint& peer_addr, char* pstr, size_t len, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, &pstr, &len, 1, duration, can_overflow, prior);} \
-template<typename Buffer> TYPE FUNNAME(const Buffer& buffer, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, buffer, duration, can_overflow, prior);} \
+#define UDP_SYNC_SEND_MSG_CALL_SWITCH(FUNNAME, TYPE) UDP_SYNC_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, TYPE, ASCS_SYNC_PRIOR_PARAM, ASCS_SYNC_PRIOR_ARG)
+#define UDP_SYNC_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, TYPE, PARAM, ARG) \
+TYPE FUNNAME(const char* pstr, size_t len, PARAM()) \
+	{return FUNNAME(peer_addr, pstr, len, ARG());} \
+TYPE FUNNAME(char* pstr, size_t len, PARAM()) \
+	{return FUNNAME(peer_addr, pstr, len, ARG());} \
+TYPE FUNNAME(const typename Family::endpoint& peer_addr, const char* pstr, size_t len, PARAM()) \
+	{return FUNNAME(peer_addr, &pstr, &len, 1, ARG());} \
+TYPE FUNNAME(const typename Family::endpoint& peer_addr, char* pstr, size_t len, PARAM()) \
+	{return FUNNAME(peer_addr, &pstr, &len, 1, ARG());} \
+template<typename Buffer> TYPE FUNNAME(const Buffer& buffer, PARAM()) \
+	{return FUNNAME(peer_addr, buffer, ARG());} \
 template<typename Buffer> \
-TYPE FUNNAME(const typename Family::endpoint& peer_addr, const Buffer& buffer, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, buffer.data(), buffer.size(), duration, can_overflow, prior);}
+TYPE FUNNAME(const typename Family::endpoint& peer_addr, const Buffer& buffer, PARAM()) \
+	{return FUNNAME(peer_addr, buffer.data(), buffer.size(), ARG());}
 
 #define UDP_SYNC_SEND_MSG(FUNNAME, NATIVE) \
-sync_call_result FUNNAME(const char* const pstr[], const size_t len[], size_t num, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, pstr, len, num, duration, can_overflow, prior);} \
+UDP_SYNC_SEND_MSG_IMPL(FUNNAME, NATIVE, ASCS_SYNC_PRIOR_PARAM, ASCS_SYNC_PRIOR_ARG) \
+UDP_SYNC_SEND_MSG_IMPL(FUNNAME, NATIVE, ASCS_SYNC_LANE_PARAM, ASCS_SYNC_LANE_ARG)
+#define UDP_SYNC_SEND_MSG_IMPL(FUNNAME, NATIVE, PARAM, ARG) \
+sync_call_result FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+	{return FUNNAME(peer_addr, pstr, len, num, ARG());} \
 sync_call_result FUNNAME(const typename Family::endpoint& peer_addr, const char* const pstr[], const size_t len[], size_t num, \
-	unsigned duration = 0, bool can_overflow = false, bool prior = false) \
+	PARAM()) \
 { \
 	if (!can_overflow && !this->shrink_send_buffer()) \
 		return sync_call_result::NOT_APPLICABLE; \
 	in_msg_type msg(peer_addr, this->packer()->pack_msg(pstr, len, num, NATIVE)); \
 	return do_direct_sync_send_msg(std::move(msg), duration, prior); \
 } \
-UDP_SYNC_SEND_MSG_CALL_SWITCH(FUNNAME, sync_call_result)
+UDP_SYNC_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, sync_call_result, PARAM, ARG)
 
 //guarantee send msg successfully even if can_overflow equal to false, success at here just means putting the msg into udp::socket_base's send buffer successfully
 //if can_overflow equal to false and the buffer is not available, will wait until it becomes available
 #define UDP_SYNC_SAFE_SEND_MSG(FUNNAME, SEND_FUNNAME) \
-sync_call_result FUNNAME(const char* const pstr[], const size_t len[], size_t num, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{return FUNNAME(peer_addr, pstr, len, num, duration, can_overflow, prior);} \
+UDP_SYNC_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, ASCS_SYNC_PRIOR_PARAM, ASCS_SYNC_PRIOR_ARG) \
+UDP_SYNC_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, ASCS_SYNC_LANE_PARAM, ASCS_SYNC_LANE_ARG)
+#define UDP_SYNC_SAFE_SEND_MSG_IMPL(FUNNAME, SEND_FUNNAME, PARAM, ARG) \
+sync_call_result FUNNAME(const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+	{return FUNNAME(peer_addr, pstr, len, num, ARG());} \
 sync_call_result FUNNAME(const typename Family::endpoint& peer_addr, \
-	const char* const pstr[], const size_t len[], size_t num, unsigned duration = 0, bool can_overflow = false, bool prior = false) \
-	{while (sync_call_result::SUCCESS != SEND_FUNNAME(peer_addr, pstr, len, num, duration, can_overflow, prior)) \
+	const char* const pstr[], const size_t len[], size_t num, PARAM()) \
+	{while (sync_call_result::SUCCESS != SEND_FUNNAME(peer_addr, pstr, len, num, ARG())) \
 		SAFE_SEND_MSG_CHECK(sync_call_result::NOT_APPLICABLE) return sync_call_result::SUCCESS;} \
-UDP_SYNC_SEND_MSG_CALL_SWITCH(FUNNAME, sync_call_result)
+UDP_SYNC_SEND_MSG_CALL_SWITCH_IMPL(FUNNAME, sync_call_result, PARAM, ARG)
 //UDP sync msg sending interface
 ///////////////////////////////////////////////////
 #endif
@@ -950,6 +1450,52 @@ public:
 };
 #endif
 
+#ifdef ASCS_COROUTINE
+//resume the coroutine which is awaiting a co_awaitable, the result must be put via the result pointer before resuming.
+template<typename T> struct co_resumer
+{
+	void operator()() const {handle.resume();}
+
+	T* result;
+	std::coroutine_handle<> handle;
+};
+
+//the awaitable of async operations, Starter (void(const co_resumer<T>&)) will be called when the coroutine is being suspended, it returns
+// false (after put the result) if the operation finished immediately, then the coroutine will not be suspended, otherwise, the resumer
+// must be invoked (only once) later. the resumer can be invoked in other threads before Starter returned, so Starter must not touch
+// anything which belongs to the coroutine after handed the resumer out.
+template<typename T, typename Starter> class co_awaitable
+{
+public:
+	co_awaitable(Starter&& starter_) : starter(std::move(starter_)), result() {}
+
+	bool await_ready() const noexcept {return false;}
+	bool await_suspend(std::coroutine_handle<> h) {auto s(std::move(starter)); return s(co_resumer<T>{&result, h});} //this awaitable may be gone after s invoked
+	T await_resume() {return std::move(result);}
+
+private:
+	Starter starter;
+	T result;
+};
+template<typename T, typename Starter> co_awaitable<T, typename std::decay<Starter>::type> make_co_awaitable(Starter&& starter)
+	{return co_awaitable<T, typename std::decay<Starter>::type>(std::forward<Starter>(starter));}
+
+//a fire-and-forget coroutine, it starts immediately and destroys itself after finished, awaitables of ascs can be awaited in any coroutine
+// (except asio::awaitable), this one is just for convenience, for example:
+// co_flow login(my_client_socket& client) {if (co_await client.async_connect() && sync_call_result::SUCCESS == co_await client.async_send(req)) ...}
+struct co_flow
+{
+	struct promise_type
+	{
+		co_flow get_return_object() {return co_flow();}
+		std::suspend_never initial_suspend() noexcept {return {};}
+		std::suspend_never final_suspend() noexcept {return {};}
+		void return_void() {}
+		void unhandled_exception() {std::terminate();} //like std::thread, nobody can catch it
+	};
+};
+#endif
+
 } //namespace
 
 #endif /* _ASCS_BASE_H_ */
@@ -719,6 +719,10 @@
  * If both macro ASCS_PASSIVE_RECV and ASCS_SYNC_RECV been defined, the first invocation (right after the connection been established)
  *  of recv_msg() will be omitted too, see the two macro for more details.
  * non_lock_queue needs its container to be thread safe even in pingpong test.
+ * object_pool::container() now returns the object storage (object_map by default), call container() of object_map to get the unordered_map.
+ * If on_msg_handle returns false (or 0 with macro ASCS_DISPATCH_BATCH_MSG), msg handling will not be retried after msg_handling_interval()
+ *  any more, but after resume_dispatch() been called (ascs calls it after each successful write), define macro ASCS_BACKPRESSURE_POLLING to
+ *  get the old behavior back, see it for more details.
  *
  * HIGHLIGHT:
  * Introduce del_socket to i_matrix, so socket can remove itself from the container (object_pool and its subclasses) who created it.
@@ -745,10 +749,80 @@
  * Add reference to standalone asio, you can execute 'git submodule init; git submodule update' after cloned ascs,
  *  then you can compile ascs examples without lack of standalone asio.
  * Add new demo debug_assistant.
+ * Add lock_free_queue (mpsc_queue), a multiple producers and single consumer queue, producers are lock-free (they never block each other
+ *  nor the consumer), it can be used as the input queue, see macro ASCS_INPUT_QUEUE for more details.
+ * Add spsc_queue, a wait-free and bounded single producer and single consumer queue, and ring_buffer, a container which stores items contiguously,
+ *  they make a pair, they can be used as the output queue, see macro ASCS_OUTPUT_QUEUE for more details.
+ * Add pooled_list, a std::list with an allocator which caches list nodes in each thread, see macro ASCS_MAX_CACHED_NODE_NUM for more details.
+ * Add chunk_deque, a deque which stores items in chunks and keeps their sizes, so finding the split point of a batch fetching (by bytes or by number)
+ *  only walks chunks rather than items, see container.h.
+ * Add multi_lane_queue, a queue which has multiple lanes with strict priority or weighted round robin scheduling, it can be used as
+ *  the input queue, then send_msg and its friends accept a lane (which replaces the bool prior parameter) to put messages into the
+ *  specified lane, see macro ASCS_LANE_NUM for more details.
+ * Add conflating_queue, a queue which holds at most one item per key (a new item replaces the queued one which has the same key),
+ *  it can be used as the input queue for feeds which only care about the latest values (market data for example).
+ * Add sharded_object_map (and sharded_object_pool), an object storage which distributes objects into ASCS_OBJECT_SHARD_NUM shards,
+ *  each shard has its own lock, so adding or deleting objects will not block readers of other shards, see object_container.h.
+ * Add slot_object_map (and slot_object_pool), an object storage which keeps objects contiguously in a vector and indexes them
+ *  by id with an open addressing table, so find, at (random access) and deletion are O(1) and traversing is cache friendly.
+ * Add snapshot_object_map (and snapshot_object_pool), an object storage which traverses objects via an immutable snapshot without
+ *  holding any lock, so broadcasting, get_statistic and clear_obsoleted_object will not block adding and deleting objects.
+ * object_pool indexes invalid objects by id and keeps the ones which finished closing in a ready list (sockets inform object_pool via
+ *  i_object_pool::on_obsoleted), so object reusing, restoring (change_object_id) and freeing no longer walk through all invalid objects.
+ * Add shared_broadcast_msg and shared_broadcast_native_msg to server_base, multi_client_base and udp::multi_socket_service_base, they pack
+ *  the message only once and put it into all sockets' send buffer directly, with ext::shared_packer (reference-counted messages), all sockets
+ *  share the same bytes rather than copying them.
+ * Add object_pool::parallel_do_something_to_all, it partitions all objects into chunks and handles them in service threads concurrently,
+ *  a callback with per chunk statistic (object number, affected number, waiting and running duration) will be invoked after all chunks finished.
+ * Add parallel_broadcast_msg and parallel_broadcast_native_msg to server_base and multi_client_base, they pack the message only once and put it
+ *  into all sockets' send buffer in service threads concurrently, sockets whose send_buf_usage() is above a given threshold can be skipped.
+ * tcp::socket_base can coalesce small msgs into a contiguous staging block before sending (see macro ASCS_SEND_COALESCE_SIZE), caps the
+ *  gather list of asio::async_write (see macro ASCS_MAX_IOV_NUM), and can hold the idle writer for a short while to batch bursts of small
+ *  msgs into one write (see macro ASCS_SEND_CORK_DELAY), statistic gathers coalesced bytes and saved writes.
+ * Message receiving and msg handling are resumed by events instead of polling timers, see macro ASCS_BACKPRESSURE_POLLING for more details.
+ * Add ascs::socket::resume_dispatch() and recv_low_watermark(float).
+ * Msg dispatching can run in a dispatch executor (ascs::i_dispatch_executor) rather than service threads, see ascs::socket::dispatch_executor and
+ *  ascs::object_pool::dispatch_executor, service_pump owns a dispatch pool (ascs::dispatch_pool, a socket always be dispatched by the same worker)
+ *  which can be enabled via service_pump::dispatch_thread_num, then slow msg handling will not delay reading, writing and timers any more.
+ * Add per worker statistic (queue depth, waiting and handling duration) to ascs::dispatch_pool.
+ * Msgs of a single link can be dispatched concurrently by keys (while in order for the same key), see ascs::socket::dispatch_by_key and macro
+ *  ASCS_DISPATCH_PARTITION_NUM.
+ * Add fan-in inbox mode, sockets push their msgs into the inbox of the object pool, and consumer threads take them out in large batches
+ *  via object_pool::on_inbox_batch, see object_pool::inbox_consumer_num and macro ASCS_MAX_INBOX_BUF.
+ * service_pump calls i_service::finalize after all service threads quit, object_pool stops inbox consumers in it.
+ * Support credit based end-to-end flow control between ascs peers (tcp only), see macro ASCS_CREDIT_FLOW_CONTROL for more details.
+ * Add i_packer::pack_credit and i_unpacker::credit_edge, ext::packer and ext::unpacker (and their wrappers) support them.
+ * Support per-message deadlines, msgs which reached their deadlines in the send buffer will be dropped rather than sent, see macro
+ *  ASCS_MSG_DEADLINE for more details.
+ * Add a global memory budget across sockets (ascs::memory_governor, service_pump owns one), sockets charge their sending and receiving
+ *  buffers against it, with high/low watermarks and three policies (reject, shed the largest consumers or pause reading on top-N sockets),
+ *  see ascs::socket::mem_governor and ascs::object_pool::mem_governor.
+ * Sync message sending no longer uses std::promise and std::future, waiters (ascs::sync_send_waiter) are pooled and reused, and a blocked
+ *  sender will not touch any futex if the msg has been sent before it starts to wait.
+ * With macro ASCS_SYNC_SEND, msg sending interfaces have a non-blocking version which takes 'const completion& prior', the callback will be
+ *  invoked (in service threads) after the msg been sent or failed, see struct ascs::completion.
+ * Msgs which will never be sent (discarded, shed, left in the sending buffer after closing without restarting, reset or destroyed) complete
+ *  their waiters and callbacks with NOT_APPLICABLE, in the thread which dropped them.
+ * Add new macro ASCS_COROUTINE to support c++20 coroutines, it provides awaitable msg sending (async_send), receiving (async_recv_batch),
+ *  connecting (async_connect) and timer (async_wait), coroutines are resumed in the dispatcher of the socket without blocking any threads.
+ * Add async_safe_send and async_safe_send_native, they suspend the coroutine until the sending buffer becomes available rather than overflow it.
+ * Add new macro ASCS_SYNC_RECV_CHANNEL and ASCS_SYNC_RECV_SPIN, sync message receiving via a bounded lock-free channel, rw_strand never waits
+ *  for sync_recv_msg and sync_recv_msg takes many batches per wakeup.
+ * Add new macro ASCS_SEND_HIGH_WATERMARK and ASCS_SEND_LOW_WATERMARK, ascs::socket::on_send_buffer_high and on_send_buffer_low will be
+ *  invoked when the sending buffer crossed them, and safe_send_msg blocks in ascs::socket::wait_send_buffer_available rather than sleeping.
+ * Only the first sender schedules do_send_msg (via an atomic doorbell) after the sending buffer became non-empty, concurrent senders no longer
+ *  post redundant handlers to rw_strand.
+ * Add new demo queue_test.
+ * Add new demo pool_test.
+ * Add new demo dispatch_test.
+ * Add new demo credit_test.
+ * Add new demo coroutine_test.
  *
  * DELETION:
  *
  * REFACTORING:
+ * Move the storage of living objects out of object_pool, object_pool now has a Container template parameter (object_map by default),
+ *  which is the storage and its lock.
  *
  * REPLACEMENTS:
  *
@@ -831,6 +905,19 @@ static_assert(ASCS_SERVER_PORT > 0, "server port must be bigger than zero.");
 #endif
 static_assert(ASCS_MAX_SEND_BUF > 0, "send buffer capacity must be bigger than zero.");
 
+#ifndef ASCS_SEND_HIGH_WATERMARK
+#define ASCS_SEND_HIGH_WATERMARK	.8f
+#endif
+#ifndef ASCS_SEND_LOW_WATERMARK
+#define ASCS_SEND_LOW_WATERMARK		.5f
+#endif
+static_assert(ASCS_SEND_HIGH_WATERMARK > 0.f && ASCS_SEND_LOW_WATERMARK >= 0.f && ASCS_SEND_LOW_WATERMARK < ASCS_SEND_HIGH_WATERMARK,
+	"the low watermark must be in [0, high watermark).");
+//after each successful write, if the usage of the sending buffer (see ascs::socket::send_buf_usage()) rose to or above the high watermark,
+// ascs::socket::on_send_buffer_high will be invoked, and then ascs::socket::on_send_buffer_low will be invoked after it dropped to or below
+// the low watermark, they can be changed via ascs::socket::send_watermarks(float, float) at runtime.
+//threads blocked in ascs::socket::wait_send_buffer_available (safe_send_msg for example) are woken up after each successful write too.
+
 //recv buffer's maximum size (bytes), it will be expanded dynamically (not fixed) within this range.
 #ifndef ASCS_MAX_RECV_BUF
 #define ASCS_MAX_RECV_BUF		(1024 * 1024) //1M, 1048576
@@ -887,6 +974,62 @@ static_assert(ASCS_DELAY_CLOSE >= 0, "delay close duration must be bigger than o
 //after sending buffer became empty, call ascs::socket::on_all_msg_send(InMsgType& msg)
 //#define ASCS_WANT_ALL_MSG_SEND_NOTIFY
 
+//tcp only, msgs smaller than this (in bytes) will be copied into a per-socket contiguous staging block before sending, adjacent small msgs
+// share one buffer in the gather list of asio::async_write, so thousands of tiny msgs (or heads and bodies packed separately by the
+// zero copy version of i_packer::pack_msg) will not become a huge iovec array. 0 means disabled.
+//with macro ASCS_WANT_MSG_SEND_NOTIFY, msgs are sent one by one, so there's nothing to coalesce.
+#ifndef ASCS_SEND_COALESCE_SIZE
+#define ASCS_SEND_COALESCE_SIZE	0
+#endif
+static_assert(ASCS_SEND_COALESCE_SIZE >= 0, "coalescing threshold must be bigger than or equal to zero.");
+
+//tcp only, max number of buffers in the gather list of one asio::async_write (IOV_MAX on most platforms), msgs beyond it will be copied
+// into the staging block (see macro ASCS_SEND_COALESCE_SIZE) no matter how big they are.
+#ifndef ASCS_MAX_IOV_NUM
+#define ASCS_MAX_IOV_NUM	1024
+#endif
+static_assert(ASCS_MAX_IOV_NUM > 1, "gather list must be able to hold at least two buffers.");
+
+//tcp only, if defined, when the writer is idle and less than ASCS_SEND_CORK_SIZE bytes are waiting for sending, ascs will hold them (cork)
+// for at most ASCS_SEND_CORK_DELAY milliseconds, the cork will be released as soon as ASCS_SEND_CORK_SIZE bytes are available, so a burst of
+// small msgs will be sent by one write (like Nagle's algorithm, but in user space and with a hard latency cap).
+//writes that are already going on are never held, msgs sent during them will be sent together by the next write anyway.
+//#define ASCS_SEND_CORK_DELAY	1 //millisecond(s)
+#ifdef ASCS_SEND_CORK_DELAY
+static_assert(ASCS_SEND_CORK_DELAY > 0, "cork delay must be bigger than zero.");
+
+#ifndef ASCS_SEND_CORK_SIZE
+#define ASCS_SEND_CORK_SIZE	4096
+#endif
+static_assert(ASCS_SEND_CORK_SIZE > 0, "cork size must be bigger than zero.");
+#endif
+
+//tcp only, end-to-end flow control between ascs peers, both peers must define it and use a packer/unpacker pair which support credit
+// frames (i_packer::pack_credit, i_unpacker::credit_edge and i_unpacker::supports_credit, ext::packer/unpacker and their wrappers do),
+// otherwise it's disabled (on this side, so the peer must use such a pair too, or it will wait for credits forever).
+//the receiver grants byte credits (the total bytes the peer may send, like the window of tcp) as its receiving buffer drains, so the
+// receiving buffer plus the kernel buffers hold at most recv_buf_size() bytes (plus one msg), the sender holds msgs in its sending buffer
+// until credits are available, credit frames piggyback on data writes and replace heartbeats, they are never blocked by credits.
+//msgs in dispatch partitions (see socket::dispatch_by_key) are counted, msgs in the inbox (see object_pool::inbox_consumer_num) are not.
+//tcp::no_delay will be set on the connection, because nagle's algorithm plus delayed ack stall credit frames.
+//see statistic::send_credit_wait_sum and tcp::socket_base::send_credit() for where the pipeline stalls.
+//#define ASCS_CREDIT_FLOW_CONTROL
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+#ifndef ASCS_CREDIT_UPDATE_THRESHOLD
+#define ASCS_CREDIT_UPDATE_THRESHOLD	.25f
+#endif
+static_assert(ASCS_CREDIT_UPDATE_THRESHOLD > 0.f && ASCS_CREDIT_UPDATE_THRESHOLD <= 1.f, "credit update threshold must be in (0, 1].");
+//new credits will not be granted until they reach this proportion of recv_buf_size(), to avoid too many credit frames.
+#endif
+
+//define this macro to let msgs carry deadlines, msg sending interfaces (send_msg, send_native_msg, safe_send_msg, direct_send_msg, broadcast
+// and shared broadcast ones, but not sync and parallel ones) will have a third version which accepts 'const deadline& prior', for example:
+// send_msg(quote, deadline(5000)) //5 seconds TTL
+// send_msg(quote, deadline(std::chrono::steady_clock::now() + std::chrono::seconds(5), true)) //absolute deadline, put it at the front of the send buffer
+//msgs which reached their deadlines before being sent will be dropped (they're checked just before being sent), see socket::on_msg_expire,
+// statistic::send_expired_msg_sum and statistic::send_expired_byte_sum. msgs sent without a deadline never expire.
+//#define ASCS_MSG_DEADLINE
+
 //object_pool will asign object ids (used to distinguish objects) from this
 #ifndef ASCS_START_OBJECT_ID
 #define ASCS_START_OBJECT_ID	0
@@ -898,6 +1041,39 @@ static_assert(ASCS_DELAY_CLOSE >= 0, "delay close duration must be bigger than o
 #endif
 static_assert(ASCS_MAX_OBJECT_NUM > 0, "object capacity must be bigger than zero.");
 
+//shard number of sharded_object_map (the object storage used by sharded_object_pool), objects are distributed by the hash of their ids,
+// each shard has its own lock (ASCS_SHARED_MUTEX_TYPE), so with more shards, adding and deleting objects (connection churn) block less finding
+// and traversing, but size() of object_pool is no longer exact during concurrent modifications and traversing (do_something_to_all)
+// visits the shards one by one.
+#ifndef ASCS_OBJECT_SHARD_NUM
+#define ASCS_OBJECT_SHARD_NUM	16
+#endif
+static_assert(ASCS_OBJECT_SHARD_NUM > 0, "shard number must be bigger than zero.");
+
+//default objects per chunk of object_pool::parallel_do_something_to_all (and parallel_broadcast_msg), each chunk will be posted to
+// service threads as one task, smaller chunks spread objects better across service threads but introduce more posting.
+//can be changed at runtime via object_pool::chunk_size.
+#ifndef ASCS_PARALLEL_CHUNK_SIZE
+#define ASCS_PARALLEL_CHUNK_SIZE	1024
+#endif
+static_assert(ASCS_PARALLEL_CHUNK_SIZE > 0, "chunk size must be bigger than zero.");
+
+//default byte budget of the fan-in inbox (see object_pool::inbox_consumer_num), after it's been used up, sockets which push msgs into
+// the inbox will suspend message receiving until consumers take msgs out of the inbox.
+//can be changed at runtime via object_pool::inbox_buf_size.
+#ifndef ASCS_MAX_INBOX_BUF
+#define ASCS_MAX_INBOX_BUF		(1024 * 1024 * 16) //16M
+#endif
+static_assert(ASCS_MAX_INBOX_BUF > 0, "inbox capacity must be bigger than zero.");
+
+//default number of sockets whose message receiving will be suspended each time the memory governor's budget been exhausted, with
+// policy memory_governor::policy::PAUSE_TOP_N (sockets who have the biggest receiving buffers go first).
+//can be changed at runtime via memory_governor::governing_policy.
+#ifndef ASCS_MEM_GOVERNOR_TOP_N
+#define ASCS_MEM_GOVERNOR_TOP_N	8
+#endif
+static_assert(ASCS_MEM_GOVERNOR_TOP_N > 0, "top n must be bigger than zero.");
+
 //if defined, objects will never be freed, but remain in object_pool waiting for reuse.
 //#define ASCS_REUSE_OBJECT
 
@@ -927,6 +1103,14 @@ static_assert(ASCS_MAX_OBJECT_NUM > 0, "object capacity must be bigger than zero
 	#endif
 #endif
 
+//how many objects at the front of the ready list will be checked at most when object_pool tries to reuse an object, objects which cannot
+// be reused right now will be rotated to the back of the ready list.
+#ifndef ASCS_MAX_READY_OBJECT_CHECK
+#define ASCS_MAX_READY_OBJECT_CHECK	16
+#elif ASCS_MAX_READY_OBJECT_CHECK <= 0
+	#error max ready object check must be bigger than zero.
+#endif
+
 //define ASCS_CLEAR_OBJECT_INTERVAL macro to let object_pool to invoke clear_obsoleted_object() automatically and periodically
 //this feature may affect performance with huge number of objects, so re-write server_socket_base::on_recv_error and invoke object_pool::del_object()
 //is recommended for long-term connection system, but for short-term connection system, you are recommended to open this feature.
@@ -994,18 +1178,53 @@ static_assert(ASCS_ASYNC_ACCEPT_NUM > 0, "async accept number must be bigger tha
 //close port reuse
 //#define ASCS_NOT_REUSE_ADDRESS
 
+//lock_free_queue can be used as the input queue too, in which message sending (producer side) is lock-free, so a preempted sender never
+// blocks other senders or do_send_msg, but it's not necessarily faster than lock_queue (the consumer moves each message into its own
+// container rather than splicing them), measure it with demo queue_test on your machine before switching to it.
+//lock_free_queue also works as the output queue, but there's only one producer (handle_msg) for the output queue, so no benefit.
 #ifndef ASCS_INPUT_QUEUE
 #define ASCS_INPUT_QUEUE lock_queue
 #endif
 #ifndef ASCS_INPUT_CONTAINER
 #define ASCS_INPUT_CONTAINER list
 #endif
+//spsc_queue can be used as the output queue, it's wait-free and bounded (1024 msgs), its circular buffer is allocated only once, then
+// message receiving will be suspended when it's full, just like the receiving buffer reaches its limit (see ASCS_MAX_RECV_BUF), messages
+// still need memory themselves (and so do list nodes if the output container is not ring_buffer), you cannot call pop_xxx_pending_recv_msg
+// while dispatching messages (it supports only one consumer), and it cannot be used as the input queue (it supports only one producer).
 #ifndef ASCS_OUTPUT_QUEUE
 #define ASCS_OUTPUT_QUEUE lock_queue
 #endif
 #ifndef ASCS_OUTPUT_CONTAINER
 #define ASCS_OUTPUT_CONTAINER list
 #endif
+//pooled_list can be used as the input and/or output container, it's a std::list with an allocator which caches list nodes in each thread,
+// and exchanges them (in batches) with a global cache, so no memory allocation for list nodes after warming up.
+//this macro defines how many list nodes can be cached by each thread (and the global cache) for each kind of list,
+// list nodes beyond that will be freed.
+#ifndef ASCS_MAX_CACHED_NODE_NUM
+#define ASCS_MAX_CACHED_NODE_NUM	4096
+#endif
+static_assert(ASCS_MAX_CACHED_NODE_NUM >= 0, "the number of cached list nodes must be bigger than or equal to zero.");
+//chunk_deque also can be used as the input and/or output container, it stores 64 items per chunk and remembers their sizes, so
+// move_items_out (which fetches a batch of messages to send) doesn't need to walk through all the items.
+//conflating_queue can be used as the input queue for feeds which only care about the latest value of each key, it needs a key extractor,
+// so define your own alias, for example: template<typename Container> using price_queue = conflating_queue<Container, price_key>;
+// then define ASCS_INPUT_QUEUE as price_queue, see demo queue_test for more details.
+//multi_lane_queue can be used as the input queue, it has ASCS_LANE_NUM lanes, messages sent with a lane (send_msg(msg, lane(n)) for example)
+// go to that lane, and others go to lane 0 (the highest priority), do_send_msg fetches messages from lanes by the scheduling policy (see
+// lane_queue for more details), so control messages can bypass the backlog of bulk messages.
+//ASCS_LANE_QUANTUM is the quantum (in bytes) of the lowest lane with the weighted round robin policy, lane n gets (ASCS_LANE_NUM - n) times of it.
+#ifndef ASCS_LANE_NUM
+#define ASCS_LANE_NUM	4
+#elif ASCS_LANE_NUM <= 0
+	#error invalid lane number.
+#endif
+#ifndef ASCS_LANE_QUANTUM
+#define ASCS_LANE_QUANTUM	4096
+#elif ASCS_LANE_QUANTUM <= 0
+	#error invalid lane quantum.
+#endif
 //we also can control the queues (and their containers) via template parameters on class 'client_socket_base'
 //'server_socket_base', 'ssl::client_socket_base' and 'ssl::server_socket_base'.
 //we even can let a socket to use different queue (and / or different container) for input and output via template parameters.
@@ -1049,13 +1268,39 @@ static_assert(ASCS_HEARTBEAT_MAX_ABSENCE > 0, "heartbeat absence must be bigger
 //#define ASCS_DECREASE_THREAD_AT_RUNTIME
 //enable decreasing service thread at runtime.
 
+//#define ASCS_BACKPRESSURE_POLLING
+//how to resume message receiving after the receiving buffer overflowed and how to retry msg handling after on_msg_handle failed.
+//without this macro (event driven), message receiving will be resumed as soon as the dispatcher drains the receiving buffer to or below
+// the low watermark (see macro ASCS_RECV_LOW_WATERMARK), and msg handling will be retried as soon as ascs::socket::resume_dispatch() is called,
+// ascs calls it after each successful write, so on_msg_handle which failed because of the sending buffer been full (echo for example) will
+// be retried automatically, otherwise, you must call it after the condition which blocked msg handling has gone. no timer is involved.
+//with this macro (polling), ascs checks the receiving buffer every msg_resuming_interval() milliseconds and retries msg handling after
+// msg_handling_interval() milliseconds, this adds up to ASCS_MSG_RESUMING_INTERVAL or ASCS_MSG_HANDLING_INTERVAL milliseconds of latency.
+
+#ifndef ASCS_RECV_LOW_WATERMARK
+#define ASCS_RECV_LOW_WATERMARK	.5f
+#endif
+static_assert(ASCS_RECV_LOW_WATERMARK >= 0.f && ASCS_RECV_LOW_WATERMARK < 1.f, "the low watermark must be in [0, 1).");
+//without macro ASCS_BACKPRESSURE_POLLING, suspended message receiving will be resumed after the usage of the receiving buffer (see
+// ascs::socket::recv_buf_usage()) dropped to or below this value.
+//this value can be changed via ascs::socket::recv_low_watermark(float) at runtime.
+
+#ifndef ASCS_DISPATCH_PARTITION_NUM
+#define ASCS_DISPATCH_PARTITION_NUM	16
+#endif
+static_assert(ASCS_DISPATCH_PARTITION_NUM > 0, "dispatch partition number must be bigger than zero.");
+//default partition number of key partitioned msg dispatching (see ascs::socket::dispatch_by_key, not available with macro ASCS_DISPATCH_BATCH_MSG),
+// keys are hashed to partitions, partitions of a socket are dispatched concurrently while msgs in a partition are dispatched in order,
+// each partition buffers up to recv_buf_size() / partition number bytes of msgs, msgs in partitions are charged against recv_buf_size()
+// (and the memory governor and credits) together with the receiving buffer, so message receiving will be suspended as usual.
+
 #ifndef ASCS_MSG_RESUMING_INTERVAL
 #define ASCS_MSG_RESUMING_INTERVAL	50 //milliseconds
 #endif
 static_assert(ASCS_MSG_RESUMING_INTERVAL >= 0, "the interval of msg resuming must be bigger than or equal to zero.");
 //msg receiving
 //if receiving buffer is overflow, message receiving will stop and resume after the buffer becomes available,
-//this is the interval of receiving buffer checking.
+//this is the interval of receiving buffer checking (only with macro ASCS_BACKPRESSURE_POLLING).
 //this value can be changed via ascs::socket::msg_resuming_interval(size_t) at runtime.
 
 #ifndef ASCS_MSG_HANDLING_INTERVAL
@@ -1063,7 +1308,7 @@ static_assert(ASCS_MSG_RESUMING_INTERVAL >= 0, "the interval of msg resuming mus
 #endif
 static_assert(ASCS_MSG_HANDLING_INTERVAL >= 0, "the interval of msg handling must be bigger than or equal to zero.");
 //msg handling
-//call on_msg_handle, if failed, retry it after ASCS_MSG_HANDLING_INTERVAL milliseconds later.
+//call on_msg_handle, if failed, retry it after ASCS_MSG_HANDLING_INTERVAL milliseconds later (only with macro ASCS_BACKPRESSURE_POLLING).
 //this value can be changed via ascs::socket::msg_handling_interval(size_t) at runtime.
 
 //#define ASCS_EXPOSE_SEND_INTERFACE
@@ -1093,15 +1338,6 @@ static_assert(ASCS_MSG_HANDLING_INTERVAL >= 0, "the interval of msg handling mus
 //if you don't define this macro, the next callback will be called at (xx:xx:xx + 21), please note.
 
 //#define ASCS_SYNC_SEND
-//before 1.12.2, asio has a problem or no ability with the detection of std::future availability with libstdc++.
-#if ASIO_VERSION >= 101202
-	#ifdef ASCS_SYNC_SEND
-		#ifndef ASIO_HAS_STD_FUTURE
-		#define ASIO_HAS_STD_FUTURE	0
-		#endif
-		static_assert(ASIO_HAS_STD_FUTURE == 1, "sync message sending needs std::future.");
-	#endif
-#endif
 //#define ASCS_SYNC_RECV
 //define these macro to gain additional series of sync message sending and receiving, they are:
 // sync_send_msg
@@ -1116,11 +1352,59 @@ static_assert(ASCS_MSG_HANDLING_INTERVAL >= 0, "the interval of msg handling mus
 // with macro ASCS_PASSIVE_RECV, in sync_recv_msg(), recv_msg() will be automatically called, but the first one (right after the connection been established)
 //  will be omitted too, see macro ASCS_PASSIVE_RECV for more details.
 // after returned from sync_recv_msg(), ascs will not maintain those messages any more.
+// with macro ASCS_SYNC_SEND, async msg sending interfaces (send_msg, send_native_msg, safe_send_msg, safe_send_native_msg and direct_send_msg)
+//  have another version which accepts 'const completion& prior', it doesn't block, the callback will be invoked in service threads after
+//  the msg been sent (SUCCESS) or failed (NOT_APPLICABLE), or in the thread which dropped the msg (NOT_APPLICABLE, for example, the thread
+//  which called pop_all_pending_send_msg or the memory governor shed the msg), for example:
+//  send_msg(order, completion([](sync_call_result re) {if (sync_call_result::SUCCESS == re) ...}))
+
+//#define ASCS_SYNC_RECV_CHANNEL	64
+//define this macro (implies ASCS_SYNC_RECV) to use the redesigned sync message receiving, after the first sync_recv_msg invocation, handle_msg
+// (in rw_strand) hands each batch of messages over to a bounded lock-free channel and continues reading immediately, rather than waits for
+// sync_recv_msg to take them (two context switches per batch), sync_recv_msg takes all batches in the channel per wakeup.
+//the value of this macro is the capacity of the channel (in batches, must be power of 2), message receiving will be suspended if the channel
+// is full, and be resumed after sync_recv_msg drained it.
+//after the first sync_recv_msg invocation, all messages go to sync_recv_msg, on_msg (with macro ASCS_SYNC_DISPATCH) and on_msg_handle will
+// not be invoked any more (until the socket been reset), so don't mix sync and async message receiving with this macro.
+#ifdef ASCS_SYNC_RECV_CHANNEL
+	static_assert(ASCS_SYNC_RECV_CHANNEL > 0 && 0 == (ASCS_SYNC_RECV_CHANNEL & (ASCS_SYNC_RECV_CHANNEL - 1)), "the capacity of the sync receiving channel must be power of 2.");
+	#ifndef ASCS_SYNC_RECV
+	#define ASCS_SYNC_RECV
+	#endif
+#endif
+
+//with macro ASCS_SYNC_RECV_CHANNEL, how many times sync_recv_msg polls the channel before blocking on the condition variable if the channel
+// is empty, spinning saves the futex wakeup if messages arrive quickly, but burns cpu, don't spin if busy threads are more than cpu cores.
+#ifndef ASCS_SYNC_RECV_SPIN
+#define ASCS_SYNC_RECV_SPIN	0
+#endif
 
 //Sync operations are not tracked by tracked_executor, please note.
 //Sync operations can be performed with async operations concurrently.
 //If both sync message receiving and async message receiving exist, sync receiving has the priority no matter it was initiated before async receiving or not.
 
+//#define ASCS_COROUTINE
+//define this macro (c++20 needed) to gain a series of awaitable interfaces, they can be awaited in any coroutine except asio::awaitable
+// (see ascs::co_flow), they are:
+// async_send, async_send_native and async_direct_send, return the result of the msg sending (see 'const completion& prior' version above)
+// async_safe_send and async_safe_send_native, like async_send, but wait for the sending buffer to become available rather than overflow it
+// async_recv_batch, returns all msgs in the receiving buffer, it takes the place of on_msg_handle after the first invocation
+// async_connect (tcp client socket only), returns whether the connection has been established or not
+// async_wait (of ascs::timer, so sockets have it too), returns after the specified interval
+//coroutines are resumed in the dispatcher of the socket (dis_strand or dis_executor, except async_wait), so they are serialized with msg
+// dispatching, and one service thread can drive a large number of sequential flows without blocking, resumptions are tracked by
+// tracked_executor, but after async_recv_batch returned an empty list (the socket has been closed), it's your responsibility to make sure
+// the socket is still alive (not been freed by object_pool) before accessing it.
+//this macro implies macro ASCS_SYNC_SEND.
+#ifdef ASCS_COROUTINE
+	#ifndef __cpp_impl_coroutine
+		#error macro ASCS_COROUTINE needs c++20 coroutine support.
+	#endif
+	#ifndef ASCS_SYNC_SEND
+	#define ASCS_SYNC_SEND
+	#endif
+#endif
+
 //#define ASCS_SYNC_DISPATCH
 //with this macro, virtual bool on_msg(std::list<OutMsgType>& msg_can) will be provided, you can rewrite it and handle all or a part of the
 // messages like virtual function on_msg_handle (with macro ASCS_DISPATCH_BATCH_MSG), if your logic is simple enough (like echo or pingpong test),
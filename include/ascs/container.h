@@ -13,6 +13,8 @@
 #ifndef _ASCS_CONTAINER_H_
 #define _ASCS_CONTAINER_H_
 
+#include <unordered_map>
+
 #include "base.h"
 
 namespace ascs
@@ -43,6 +45,35 @@ private:
 	std::mutex mutex; //std::mutex is more efficient than std::shared_(timed_)mutex
 };
 
+//find the end of the first max_item_num items, and return their total size via size
+template<typename Container> typename Container::iterator find_end_by_num(Container& can, size_t max_item_num, size_t& size)
+{
+	size = 0;
+	auto end_iter = std::begin(can);
+	for (size_t index = 0; index < max_item_num && end_iter != std::end(can); ++index, ++end_iter)
+		size += end_iter->size();
+
+	return end_iter;
+}
+
+//find the end of the first items whose total size reaches max_size_in_byte, and return their total size via size
+template<typename Container> typename Container::iterator find_end_by_size(Container& can, size_t max_size_in_byte, size_t& size)
+{
+	size = 0;
+	auto end_iter = std::begin(can);
+	while (end_iter != std::end(can)) //at least one item (if available) even max_size_in_byte is zero
+		if ((size += end_iter++->size()) >= max_size_in_byte)
+			break;
+
+	return end_iter;
+}
+
+//containers can provide more efficient implementations (must be declared before queue), see chunk_deque for example.
+template<typename T> class chunk_deque;
+template<typename T> size_t get_size_in_byte(const chunk_deque<T>& can);
+template<typename T> typename chunk_deque<T>::iterator find_end_by_num(chunk_deque<T>& can, size_t max_item_num, size_t& size);
+template<typename T> typename chunk_deque<T>::iterator find_end_by_size(chunk_deque<T>& can, size_t max_size_in_byte, size_t& size);
+
 //Container must at least has the following functions (like std::list):
 // Container() and Container(size_t) constructor
 // empty, must be thread safe, but doesn't have to be consistent
@@ -164,10 +195,8 @@ public:
 		}
 		else if (max_item_num > 0)
 		{
-			size_t size = 0, index = 0;
-			auto end_iter = this->begin();
-			do_something_to_one_([&](const_reference item) {if (++index > max_item_num) return true; size += item.size(); ++end_iter; return false;});
-
+			size_t size = 0;
+			auto end_iter = ascs::find_end_by_num(static_cast<Container&>(*this), max_item_num, size);
 			move_items_out(dest, end_iter, size);
 		}
 	}
@@ -179,9 +208,7 @@ public:
 		else
 		{
 			size_t size = 0;
-			auto end_iter = this->begin();
-			do_something_to_one_([&](const_reference item) {size += item.size(); ++end_iter; if (size >= max_size_in_byte) return true; return false;});
-
+			auto end_iter = ascs::find_end_by_size(static_cast<Container&>(*this), max_size_in_byte, size);
 			move_items_out(dest, end_iter, size);
 		}
 	}
@@ -216,9 +243,1298 @@ private:
 	size_t total_size;
 };
 
+//multiple producers and single consumer queue, producers are lock-free, they just push nodes (each holds one item inline) to a linked
+// list (the inbox), the consumer then moves items out of the inbox directly, so it's very suitable for input queue (many threads send
+// messages, but only do_send_msg which is in rw_strand fetches them).
+//nodes are allocated via pooled_allocator, so the queue itself doesn't allocate memory per item after warming up (the consumer's
+// container still may), and producers count bytes in sharded counters (by thread id), the consumer counts bytes it took out in its own
+// counter, so producers neither contend for one counter nor for the consumer's cache line, size_in_byte sums them up.
+//consumer side functions (try_dequeue, move_items_out, swap, clear and do_something_to_all/one) are serialized by Lockable (it
+// never blocks producers), so they're still thread safe (for example pop_first_pending_send_msg), so do lock() and unlock() with
+// the not thread safe ones (so ASCS_SHRINK_SEND_BUFFER still works).
+//prior items (enqueue_front and move_items_in_front) go to a lock-free stack and will be moved to the front of the inbox by the consumer,
+// so the latest prior item always comes first, just like queue.
+template<typename Container, typename Lockable>
+class mpsc_queue : public Lockable
+{
+public:
+	typedef typename Container::value_type value_type;
+	typedef typename Container::size_type size_type;
+	typedef typename Container::reference reference;
+	typedef typename Container::const_reference const_reference;
+
+private:
+	struct node
+	{
+		node() : next(nullptr) {}
+		template<typename T> node(T&& item_) : next(nullptr), item(std::forward<T>(item_)) {}
+
+		std::atomic<node*> next;
+		value_type item;
+	};
+#if defined(_MSC_VER) && _MSC_VER < 1900 //Visual C++ 12.0 (2013) doesn't support thread_local
+	typedef std::allocator<node> node_allocator;
+#else
+	typedef pooled_allocator<node> node_allocator;
+#endif
+
+	static const size_t SHARD_NUM = 8; //must be power of 2
+	struct shard {shard() : size(0) {} std::atomic_size_t size; char padding[64 - sizeof(std::atomic_size_t)];};
+
+public:
+	mpsc_queue() : head(new_node()), front(nullptr), out_size(0), prior_head(nullptr) {tail = head.load(std::memory_order_relaxed);}
+	mpsc_queue(size_t capacity) : mpsc_queue() {}
+	~mpsc_queue() {clear_(); delete_node(head.load(std::memory_order_relaxed));}
+
+	//thread safe
+	bool is_thread_safe() const {return true;}
+	//all bytes put in minus all bytes taken out, the consumer's counter is read first, so the result never underflows.
+	size_t size_in_byte() const
+	{
+		auto size = (size_t) 0 - out_size.load(std::memory_order_acquire);
+		for (auto& item : in_sizes)
+			size += item.size.load(std::memory_order_acquire);
+
+		return size;
+	}
+	bool empty() const
+	{
+		return nullptr == front.load(std::memory_order_acquire) && nullptr == prior_head.load(std::memory_order_acquire) &&
+			tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire); //never dereference head, the consumer may free it
+	}
+
+	//producer side, lock-free
+	template<typename T> bool enqueue(T&& item) {auto n = make_node(std::forward<T>(item)); if (nullptr == n) return false; push(n, n); return true;}
+	void move_items_in(Container& src, size_t size_in_byte = 0) {node* last; auto first = make_nodes(src, size_in_byte, last); if (nullptr != first) push(first, last);}
+	template<typename T> bool enqueue_front(T&& item) {auto n = make_node(std::forward<T>(item)); if (nullptr == n) return false; push_front(n, n); return true;}
+	void move_items_in_front(Container& src, size_t size_in_byte = 0)
+		{node* last; auto first = make_nodes(src, size_in_byte, last); if (nullptr != first) push_front(first, last);}
+
+	//consumer side
+	void clear() {typename Lockable::lock_guard lock(*this); clear_();}
+	void swap(Container& can)
+	{
+		typename Lockable::lock_guard lock(*this);
+		Container temp;
+		move_items_out_(temp);
+		node* last;
+		auto first = make_nodes(can, 0, last);
+		if (nullptr != first)
+		{
+			last->next.store(front.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			front.store(first, std::memory_order_release);
+		}
+		can.swap(temp);
+	}
+
+	bool try_dequeue(reference item) {typename Lockable::lock_guard lock(*this); return try_dequeue_(item);}
+	void move_items_out(Container& dest, size_t max_item_num = -1) {typename Lockable::lock_guard lock(*this); move_items_out_(dest, max_item_num);}
+	void move_items_out(size_t max_size_in_byte, Container& dest) {typename Lockable::lock_guard lock(*this); move_items_out_(max_size_in_byte, dest);}
+	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred) {typename Lockable::lock_guard lock(*this); do_something_to_all_(__pred);}
+	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred) {typename Lockable::lock_guard lock(*this); do_something_to_one_(__pred);}
+	//thread safe
+
+	//not thread safe (with other consumer side functions)
+	bool try_dequeue_(reference item)
+	{
+		fetch_prior_();
+		auto n = first_();
+		if (nullptr == n)
+			return false;
+
+		item.swap(n->item);
+		out_size.fetch_add(item.size(), std::memory_order_release);
+		{value_type temp(std::move(n->item));} //release what item held before (n may become the dummy node and live on)
+		pop_(n);
+		return true;
+	}
+
+	void move_items_out_(Container& dest, size_t max_item_num = -1)
+	{
+		fetch_prior_();
+		size_t size = 0;
+		for (node* n; max_item_num > 0 && nullptr != (n = first_()); --max_item_num)
+		{
+			size += n->item.size();
+			dest.emplace_back(std::move(n->item));
+			pop_(n);
+		}
+		out_size.fetch_add(size, std::memory_order_release);
+	}
+
+	void move_items_out_(size_t max_size_in_byte, Container& dest)
+	{
+		fetch_prior_();
+		size_t size = 0;
+		for (node* n; nullptr != (n = first_());) //at least one item (if available) even max_size_in_byte is zero
+		{
+			size += n->item.size();
+			dest.emplace_back(std::move(n->item));
+			pop_(n);
+			if (size >= max_size_in_byte)
+				break;
+		}
+		out_size.fetch_add(size, std::memory_order_release);
+	}
+
+	template<typename _Predicate>
+	void do_something_to_all_(const _Predicate& __pred) {do_something_to_one_([&](reference item) {__pred(item); return false;});}
+
+	template<typename _Predicate> void do_something_to_one_(const _Predicate& __pred)
+	{
+		fetch_prior_();
+		for (auto n = front.load(std::memory_order_relaxed); nullptr != n; n = n->next.load(std::memory_order_relaxed))
+			if (__pred(n->item))
+				return;
+		for (auto n = head.load(std::memory_order_relaxed)->next.load(std::memory_order_acquire); nullptr != n; n = n->next.load(std::memory_order_acquire))
+			if (__pred(n->item))
+				return;
+	}
+	//not thread safe
+
+private:
+	template<typename... Args> static node* new_node(Args&&... args)
+	{
+		node_allocator allocator;
+		auto n = allocator.allocate(1);
+		try {new (n) node(std::forward<Args>(args)...);}
+		catch (...) {allocator.deallocate(n, 1); throw;}
+
+		return n;
+	}
+	static void delete_node(node* n) {n->~node(); node_allocator().deallocate(n, 1);}
+
+	//before pushing, so the consumer never takes out bytes which have not been counted (see size_in_byte)
+	void count_in(size_t size) {in_sizes[std::hash<std::thread::id>()(std::this_thread::get_id()) & (SHARD_NUM - 1)].size.fetch_add(size, std::memory_order_relaxed);}
+
+	template<typename T> node* make_node(T&& item)
+	{
+		try
+		{
+			auto size = item.size();
+			auto n = new_node(std::forward<T>(item));
+			count_in(size);
+			return n;
+		}
+		catch (const std::exception& e)
+		{
+			unified_out::error_out("cannot hold more objects (%s)", e.what());
+			return nullptr;
+		}
+	}
+
+	//link all items in src (src will be empty) together, return the first node (null if src is empty) and the last one (via last)
+	node* make_nodes(Container& src, size_t size_in_byte, node*& last)
+	{
+		if (0 == size_in_byte)
+			size_in_byte = ascs::get_size_in_byte(src);
+		else
+			assert(ascs::get_size_in_byte(src) == size_in_byte);
+
+		node* first = nullptr;
+		last = nullptr;
+		for (auto& item : src)
+		{
+			auto n = new_node(std::move(item));
+			if (nullptr == last)
+				first = n;
+			else
+				last->next.store(n, std::memory_order_relaxed); //will be published by push or push_front
+			last = n;
+		}
+		src.clear();
+
+		count_in(size_in_byte);
+		return first;
+	}
+
+	void push(node* first, node* last) {tail.exchange(last, std::memory_order_acq_rel)->next.store(first, std::memory_order_release);}
+	void push_front(node* first, node* last)
+	{
+		auto top = prior_head.load(std::memory_order_relaxed);
+		do
+			last->next.store(top, std::memory_order_relaxed);
+		while (!prior_head.compare_exchange_weak(top, first, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	//move the prior stack to the front of the inbox
+	void fetch_prior_()
+	{
+		if (nullptr == prior_head.load(std::memory_order_relaxed))
+			return;
+
+		auto first = prior_head.exchange(nullptr, std::memory_order_acquire), last = first;
+		for (auto next = last->next.load(std::memory_order_relaxed); nullptr != next; next = last->next.load(std::memory_order_relaxed))
+			last = next;
+		last->next.store(front.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		front.store(first, std::memory_order_release);
+	}
+
+	//the first node which holds an item (prior items first), a node which is being linked by a producer is invisible until linked.
+	node* first_() const {auto n = front.load(std::memory_order_relaxed); return nullptr != n ? n : head.load(std::memory_order_relaxed)->next.load(std::memory_order_acquire);}
+	void pop_(node* n)
+	{
+		if (n == front.load(std::memory_order_relaxed))
+		{
+			front.store(n->next.load(std::memory_order_relaxed), std::memory_order_release);
+			delete_node(n);
+		}
+		else //n becomes the new dummy node, its item has been moved out
+		{
+			delete_node(head.load(std::memory_order_relaxed));
+			head.store(n, std::memory_order_release);
+		}
+	}
+
+	void clear_()
+	{
+		struct sink {void emplace_back(value_type&& item) {value_type temp(std::move(item));}} dest;
+		fetch_prior_();
+		size_t size = 0;
+		for (node* n; nullptr != (n = first_()); pop_(n))
+		{
+			size += n->item.size();
+			dest.emplace_back(std::move(n->item));
+		}
+		out_size.fetch_add(size, std::memory_order_release);
+	}
+
+private:
+	std::atomic<node*> head; //consumer side, the dummy node of the inbox
+	std::atomic<node*> front; //consumer side, prior items and items swapped in, they come before the inbox
+	std::atomic_size_t out_size; //consumer side, bytes taken out (minus bytes swapped in, it can wrap, which is still right)
+	char padding[64]; //keep the consumer and producers on different cache lines
+	std::atomic<node*> tail, prior_head; //producer side
+	char padding2[64];
+	shard in_sizes[SHARD_NUM]; //producer side, bytes put in
+};
+
+//list-compatible container which doesn't allocate memory for each item (after warming up), see pooled_allocator for more details.
+#if defined(_MSC_VER) && _MSC_VER < 1900
+template<typename T> using pooled_list = std::list<T>; //Visual C++ 12.0 (2013) doesn't support thread_local
+#else
+template<typename T> using pooled_list = std::list<T, pooled_allocator<T>>;
+#endif
+
+//a circular buffer which satisfies the requirements of Container (see queue), items are stored contiguously and the buffer grows
+// like std::vector, so there's no memory allocation per item, but splice is O(n) rather than O(1) (std::list), please note.
+template<typename T>
+class ring_buffer
+{
+protected:
+	template<typename Ring, typename Value>
+	class basic_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Value value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef Value* pointer;
+		typedef Value& reference;
+
+		basic_iterator() : ring(nullptr), index(0) {}
+		basic_iterator(Ring* ring_, size_t index_) : ring(ring_), index(index_) {}
+		template<typename R, typename V> basic_iterator(const basic_iterator<R, V>& other) : ring(other.ring), index(other.index) {}
+
+		reference operator*() const {return ring->at(index);}
+		pointer operator->() const {return &ring->at(index);}
+		basic_iterator& operator++() {++index; return *this;}
+		basic_iterator operator++(int) {auto re = *this; ++index; return re;}
+		template<typename R, typename V> bool operator==(const basic_iterator<R, V>& other) const {return index == other.index;}
+		template<typename R, typename V> bool operator!=(const basic_iterator<R, V>& other) const {return index != other.index;}
+
+	private:
+		template<typename, typename> friend class basic_iterator;
+		friend class ring_buffer;
+
+		Ring* ring;
+		size_t index; //logical index, begin() is 0 and end() is size()
+	};
+
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef basic_iterator<ring_buffer, T> iterator;
+	typedef basic_iterator<const ring_buffer, const T> const_iterator;
+
+	ring_buffer() : buffer(nullptr), buffer_size(0), first(0), num(0) {}
+	ring_buffer(size_t capacity) : ring_buffer() {reserve(capacity);}
+	ring_buffer(const ring_buffer& other) : ring_buffer() {reserve(other.num); for (auto& item : other) emplace_back(item);}
+	ring_buffer(ring_buffer&& other) : ring_buffer() {swap(other);}
+	~ring_buffer() {clear(); std::allocator<T>().deallocate(buffer, buffer_size);}
+
+	ring_buffer& operator=(const ring_buffer& other) {if (this != &other) {ring_buffer temp(other); swap(temp);} return *this;}
+	ring_buffer& operator=(ring_buffer&& other) {clear(); swap(other); return *this;}
+
+	bool empty() const {return 0 == num;}
+	size_t size() const {return num;}
+	size_t capacity() const {return buffer_size;}
+	void clear() {while (!empty()) pop_front(); first = 0;}
+	void swap(ring_buffer& other) {std::swap(buffer, other.buffer); std::swap(buffer_size, other.buffer_size); std::swap(first, other.first); std::swap(num, other.num);}
+
+	void reserve(size_t capacity)
+	{
+		if (capacity <= buffer_size)
+			return;
+
+		auto new_size = std::max(buffer_size, (size_t) 16);
+		while (new_size < capacity)
+			new_size <<= 1; //must be power of 2
+
+		std::allocator<T> allocator;
+		auto new_buffer = allocator.allocate(new_size);
+		for (size_t i = 0; i < num; ++i)
+		{
+			new (new_buffer + i) T(std::move(at(i)));
+			at(i).~T();
+		}
+		allocator.deallocate(buffer, buffer_size);
+
+		buffer = new_buffer;
+		buffer_size = new_size;
+		first = 0;
+	}
+
+	template<typename... Args> void emplace_back(Args&&... args)
+		{reserve(num + 1); new (buffer + ((first + num) & (buffer_size - 1))) T(std::forward<Args>(args)...); ++num;}
+	template<typename... Args> void emplace_front(Args&&... args)
+	{
+		reserve(num + 1);
+		auto index = (first + buffer_size - 1) & (buffer_size - 1);
+		new (buffer + index) T(std::forward<Args>(args)...);
+		first = index;
+		++num;
+	}
+	void pop_front() {assert(!empty()); front().~T(); first = (first + 1) & (buffer_size - 1); --num;}
+
+	reference front() {return at(0);}
+	const_reference front() const {return at(0);}
+	reference back() {return at(num - 1);}
+	const_reference back() const {return at(num - 1);}
+	reference at(size_t index) {return buffer[(first + index) & (buffer_size - 1)];}
+	const_reference at(size_t index) const {return buffer[(first + index) & (buffer_size - 1)];}
+
+	iterator begin() {return iterator(this, 0);}
+	const_iterator begin() const {return const_iterator(this, 0);}
+	iterator end() {return iterator(this, num);}
+	const_iterator end() const {return const_iterator(this, num);}
+
+	//move items rather than relinking them (as std::list does), and only inserting at the front or at the back is efficient.
+	void splice(const_iterator pos, ring_buffer& other) {splice(pos, other, other.begin(), other.end());}
+	void splice(const_iterator pos, ring_buffer& other, const_iterator first_iter, const_iterator last_iter)
+	{
+		assert(this != &other && first_iter.index <= last_iter.index && last_iter.index <= other.num);
+		auto n = last_iter.index - first_iter.index;
+		if (0 == n)
+			return;
+
+		reserve(num + n);
+		if (pos.index == num)
+			for (auto i = first_iter.index; i < last_iter.index; ++i)
+				emplace_back(std::move(other.at(i)));
+		else if (0 == pos.index)
+			for (auto i = last_iter.index; i > first_iter.index; --i)
+				emplace_front(std::move(other.at(i - 1)));
+		else
+		{
+			ring_buffer temp(num + n);
+			for (size_t i = 0; i < pos.index; ++i)
+				temp.emplace_back(std::move(at(i)));
+			for (auto i = first_iter.index; i < last_iter.index; ++i)
+				temp.emplace_back(std::move(other.at(i)));
+			for (auto i = pos.index; i < num; ++i)
+				temp.emplace_back(std::move(at(i)));
+			swap(temp);
+		}
+
+		other.erase(first_iter.index, last_iter.index);
+	}
+
+protected:
+	void erase(size_t first_index, size_t last_index)
+	{
+		if (0 == first_index)
+			for (; first_index < last_index; ++first_index)
+				pop_front();
+		else
+		{
+			ring_buffer temp(num - (last_index - first_index));
+			for (size_t i = 0; i < num; ++i)
+				if (i < first_index || i >= last_index)
+					temp.emplace_back(std::move(at(i)));
+			swap(temp);
+		}
+	}
+
+private:
+	T* buffer;
+	size_t buffer_size, first, num;
+};
+
+//a deque which stores items in a linked list of chunks, each chunk holds CHUNK_SIZE items contiguously, it satisfies the requirements
+// of Container (see queue), T must have size() function (like messages).
+//each chunk also records the size of each item and their total size, so the total size of a chunk deque is O(1), and finding the end of
+// the first items whose total size reaches a specific value (or the first n items, see queue::move_items_out_) is O(chunks),
+// splice is O(1) on chunk boundaries (like std::list), otherwise O(CHUNK_SIZE) (need to split a chunk).
+//a spare chunk is kept after the chunk deque becomes empty, so no memory allocation if items come and go regularly (like a queue).
+template<typename T>
+class chunk_deque
+{
+public:
+	static const size_t CHUNK_SIZE = 64;
+
+protected:
+	struct chunk
+	{
+		chunk() : prev(nullptr), next(nullptr), first(0), last(0), size_in_byte(0) {}
+
+		T& at(size_t index) {return *(T*) &items[index];}
+
+		chunk* prev;
+		chunk* next;
+		size_t first, last; //valid items are [first, last)
+		size_t size_in_byte;
+		size_t sizes[CHUNK_SIZE];
+		typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type items[CHUNK_SIZE];
+	};
+
+	template<typename Value>
+	class basic_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Value value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef Value* pointer;
+		typedef Value& reference;
+
+		basic_iterator() : c(nullptr), index(0) {}
+		basic_iterator(chunk* c_, size_t index_) : c(c_), index(index_) {}
+		template<typename V> basic_iterator(const basic_iterator<V>& other) : c(other.c), index(other.index) {}
+
+		reference operator*() const {return c->at(index);}
+		pointer operator->() const {return &c->at(index);}
+		basic_iterator& operator++() {if (++index == c->last) {c = c->next; index = nullptr == c ? 0 : c->first;} return *this;}
+		basic_iterator operator++(int) {auto re = *this; ++*this; return re;}
+		template<typename V> bool operator==(const basic_iterator<V>& other) const {return c == other.c && index == other.index;}
+		template<typename V> bool operator!=(const basic_iterator<V>& other) const {return !(*this == other);}
+
+	private:
+		template<typename> friend class basic_iterator;
+		friend class chunk_deque;
+
+		chunk* c; //nullptr means end()
+		size_t index;
+	};
+
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef basic_iterator<T> iterator;
+	typedef basic_iterator<const T> const_iterator;
+
+	chunk_deque() : head(nullptr), tail(nullptr), spare(nullptr), num(0), total_size(0) {}
+	chunk_deque(size_t capacity) : chunk_deque() {}
+	chunk_deque(const chunk_deque& other) : chunk_deque() {for (auto& item : other) emplace_back(item);}
+	chunk_deque(chunk_deque&& other) : chunk_deque() {swap(other);}
+	~chunk_deque() {clear(); delete spare;}
+
+	chunk_deque& operator=(const chunk_deque& other) {if (this != &other) {chunk_deque temp(other); swap(temp);} return *this;}
+	chunk_deque& operator=(chunk_deque&& other) {clear(); swap(other); return *this;}
+
+	bool empty() const {return 0 == num;}
+	size_t size() const {return num;}
+	size_t size_in_byte() const {return total_size;}
+	void clear() {while (!empty()) pop_front();}
+	void swap(chunk_deque& other)
+	{
+		std::swap(head, other.head);
+		std::swap(tail, other.tail);
+		std::swap(spare, other.spare);
+		std::swap(num, other.num);
+		std::swap(total_size, other.total_size);
+	}
+
+	template<typename... Args> void emplace_back(Args&&... args)
+	{
+		if (nullptr == tail || CHUNK_SIZE == tail->last)
+			link(nullptr, new_chunk(0));
+
+		auto& item = *new (&tail->items[tail->last]) T(std::forward<Args>(args)...);
+		record(tail, tail->last++, item.size());
+	}
+
+	template<typename... Args> void emplace_front(Args&&... args)
+	{
+		if (nullptr == head || 0 == head->first)
+			link(head, new_chunk(CHUNK_SIZE));
+
+		auto& item = *new (&head->items[head->first - 1]) T(std::forward<Args>(args)...);
+		record(head, --head->first, item.size());
+	}
+
+	void pop_front()
+	{
+		assert(!empty());
+		auto c = head;
+		c->at(c->first).~T();
+		c->size_in_byte -= c->sizes[c->first];
+		total_size -= c->sizes[c->first];
+		--num;
+
+		if (++c->first == c->last)
+		{
+			unlink(c, c->next);
+			free_chunk(c);
+		}
+	}
+
+	reference front() {return head->at(head->first);}
+	const_reference front() const {return head->at(head->first);}
+	reference back() {return tail->at(tail->last - 1);}
+	const_reference back() const {return tail->at(tail->last - 1);}
+
+	iterator begin() {return nullptr == head ? iterator() : iterator(head, head->first);}
+	const_iterator begin() const {return nullptr == head ? const_iterator() : const_iterator(head, head->first);}
+	iterator end() {return iterator();}
+	const_iterator end() const {return const_iterator();}
+
+	void splice(const_iterator pos, chunk_deque& other) {splice(pos, other, other.begin(), other.end());}
+	void splice(const_iterator pos, chunk_deque& other, const_iterator first_iter, const_iterator last_iter)
+	{
+		assert(this != &other);
+		if (first_iter == last_iter)
+			return;
+
+		auto last_chunk = other.split(last_iter); //must split at last_iter first, see split
+		auto first_chunk = other.split(first_iter);
+		auto end_chunk = nullptr == last_chunk ? other.tail : last_chunk->prev;
+
+		size_t n = 0, size = 0;
+		for (auto c = first_chunk;; c = c->next)
+		{
+			n += c->last - c->first;
+			size += c->size_in_byte;
+			if (c == end_chunk)
+				break;
+		}
+
+		other.unlink(first_chunk, last_chunk);
+		other.num -= n;
+		other.total_size -= size;
+
+		first_chunk->prev = end_chunk->next = nullptr;
+		auto pos_chunk = split(pos);
+		for (auto c = first_chunk; nullptr != c;)
+		{
+			auto next = c->next;
+			link(pos_chunk, c);
+			c = next;
+		}
+		num += n;
+		total_size += size;
+	}
+
+protected:
+	template<typename U> friend typename chunk_deque<U>::iterator find_end_by_num(chunk_deque<U>&, size_t, size_t&);
+	template<typename U> friend typename chunk_deque<U>::iterator find_end_by_size(chunk_deque<U>&, size_t, size_t&);
+
+	chunk* new_chunk(size_t pos)
+	{
+		auto c = spare;
+		if (nullptr == c)
+			c = new chunk;
+		else
+			spare = nullptr;
+
+		c->first = c->last = pos;
+		c->size_in_byte = 0;
+		return c;
+	}
+	void free_chunk(chunk* c) {if (nullptr == spare) spare = c; else delete c;}
+
+	void record(chunk* c, size_t index, size_t size) {c->sizes[index] = size; c->size_in_byte += size; total_size += size; ++num;}
+
+	//link c before pos (nullptr means the end)
+	void link(chunk* pos, chunk* c)
+	{
+		c->next = pos;
+		c->prev = nullptr == pos ? tail : pos->prev;
+		(nullptr == c->prev ? head : c->prev->next) = c;
+		(nullptr == pos ? tail : pos->prev) = c;
+	}
+
+	//unlink chunks [first, last) (nullptr means the end)
+	void unlink(chunk* first, chunk* last)
+	{
+		auto prev = first->prev;
+		(nullptr == prev ? head : prev->next) = last;
+		(nullptr == last ? tail : last->prev) = prev;
+	}
+
+	//make sure pos is the beginning of a chunk and return that chunk (nullptr means the end), items after pos will be moved to a new chunk,
+	// so iterators before pos keep valid.
+	chunk* split(const_iterator pos)
+	{
+		auto c = pos.c;
+		if (nullptr == c || pos.index == c->first)
+			return c;
+
+		auto new_c = new_chunk(0);
+		for (auto i = pos.index; i < c->last; ++i)
+		{
+			auto& item = c->at(i);
+			new (&new_c->items[new_c->last]) T(std::move(item));
+			item.~T();
+
+			new_c->sizes[new_c->last++] = c->sizes[i];
+			new_c->size_in_byte += c->sizes[i];
+			c->size_in_byte -= c->sizes[i];
+		}
+		c->last = pos.index;
+		link(c->next, new_c);
+
+		return new_c;
+	}
+
+private:
+	chunk* head;
+	chunk* tail;
+	chunk* spare;
+	size_t num, total_size;
+};
+
+template<typename T> size_t get_size_in_byte(const chunk_deque<T>& can) {return can.size_in_byte();}
+
+template<typename T> typename chunk_deque<T>::iterator find_end_by_num(chunk_deque<T>& can, size_t max_item_num, size_t& size)
+{
+	size = 0;
+	for (auto c = can.head; nullptr != c; c = c->next)
+	{
+		auto n = c->last - c->first;
+		if (max_item_num >= n)
+		{
+			size += c->size_in_byte;
+			max_item_num -= n;
+		}
+		else
+		{
+			auto index = c->first;
+			for (; max_item_num > 0; --max_item_num)
+				size += c->sizes[index++];
+
+			return typename chunk_deque<T>::iterator(c, index);
+		}
+	}
+
+	return can.end();
+}
+
+template<typename T> typename chunk_deque<T>::iterator find_end_by_size(chunk_deque<T>& can, size_t max_size_in_byte, size_t& size)
+{
+	size = 0;
+	for (auto c = can.head; nullptr != c; c = c->next)
+		if (size + c->size_in_byte < max_size_in_byte)
+			size += c->size_in_byte;
+		else //at least one item even max_size_in_byte is zero
+		{
+			auto index = c->first;
+			while ((size += c->sizes[index++]) < max_size_in_byte);
+
+			return index == c->last ? typename chunk_deque<T>::iterator(c->next, nullptr == c->next ? 0 : c->next->first) :
+				typename chunk_deque<T>::iterator(c, index);
+		}
+
+	return can.end();
+}
+
+//single producer and single consumer queue, it's wait-free, items are stored in a circular buffer (see ring_buffer) which is allocated
+// at construction and will never be reallocated, so it's bounded, if it's full, enqueue returns false and move_items_in leaves the items
+// which cannot be held in the source container, the socket then suspends message receiving until the consumer made room (see full()).
+//it's suitable for output queue (only handle_msg in rw_strand produces items and only do_dispatch_msg in dis_strand consumes items),
+// this also means it cannot be used as input queue and you cannot call pop_xxx_pending_recv_msg while dispatching messages.
+//only the consumer can call try_dequeue, move_items_out, swap, clear, empty and do_something_to_all/one, size_in_byte and full can be
+// called in any thread, enqueue_front and move_items_in_front are not supported (only the consumer can insert items at the front).
+//each side only writes its own counters (the index and the total size of items it has put in or taken out), so there's no
+// read-modify-write operation shared by both sides, size_in_byte is the difference of the two total sizes.
+//Container is just used to transfer items in and out, so it can be any kind of Container, but std::list (the default container) will
+// allocate memory for each item, so ring_buffer is the best choice, they make a pair.
+template<typename Container>
+class spsc_queue : public dummy_lockable
+{
+public:
+	typedef typename Container::value_type value_type;
+	typedef typename Container::size_type size_type;
+	typedef typename Container::reference reference;
+	typedef typename Container::const_reference const_reference;
+
+	spsc_queue(size_t capacity_ = 1024) : capacity(round_up(capacity_)), items(std::allocator<value_type>().allocate(capacity)),
+		head(0), out_size(0), tail_cache(0), tail(0), in_size(0), head_cache(0) {}
+	~spsc_queue() {clear(); std::allocator<value_type>().deallocate(items, capacity);}
+
+	//any thread
+	bool is_thread_safe() const {return true;}
+	size_t size_in_byte() const {auto size = out_size.load(std::memory_order_acquire); return in_size.load(std::memory_order_acquire) - size;}
+	bool full() const {auto head_ = head.load(std::memory_order_acquire); return tail.load(std::memory_order_acquire) - head_ >= capacity;}
+
+	//the producer
+	template<typename T> bool enqueue(T&& item)
+	{
+		auto tail_ = tail.load(std::memory_order_relaxed);
+		if (!has_room(tail_))
+			return false;
+
+		push(tail_, std::forward<T>(item));
+		tail.store(tail_ + 1, std::memory_order_release);
+		return true;
+	}
+
+	//items which cannot be held (the queue is full) will be left in src.
+	void move_items_in(Container& src, size_t size_in_byte = 0)
+	{
+		auto tail_ = tail.load(std::memory_order_relaxed), first = tail_;
+		auto iter = std::begin(src);
+		for (; iter != std::end(src) && has_room(tail_); ++iter, ++tail_)
+			push(tail_, std::move(*iter));
+		tail.store(tail_, std::memory_order_release);
+
+		if (std::end(src) == iter)
+			src.clear();
+		else
+			for (; first != tail_; ++first)
+				src.pop_front();
+	}
+
+	//the consumer
+	bool empty() const {return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);}
+	void clear() {move_items_out_(dummy_container());}
+	//only the producer can put items into this queue, so can must be empty, otherwise nothing will be swapped and false will be returned.
+	bool swap(Container& can) {if (!can.empty()) return false; move_items_out_(can); return true;}
+
+	bool try_dequeue(reference item) {return try_dequeue_(item);}
+	void move_items_out(Container& dest, size_t max_item_num = -1) {move_items_out_(dest, max_item_num);}
+	void move_items_out(size_t max_size_in_byte, Container& dest) {move_items_out_(max_size_in_byte, dest);}
+	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred) {do_something_to_all_(__pred);}
+	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred) {do_something_to_one_(__pred);}
+
+	bool try_dequeue_(reference item)
+	{
+		auto head_ = head.load(std::memory_order_relaxed);
+		if (head_ == tail_cache && head_ == (tail_cache = tail.load(std::memory_order_acquire)))
+			return false;
+
+		item.swap(at(head_));
+		pop(head_ + 1, item.size());
+		return true;
+	}
+
+	template<typename C> void move_items_out_(C&& dest, size_t max_item_num = -1)
+	{
+		size_t size = 0;
+		auto head_ = head.load(std::memory_order_relaxed);
+		for (size_t num = 0; num < max_item_num && available(head_); ++num, ++head_)
+		{
+			size += at(head_).size();
+			dest.emplace_back(std::move(at(head_)));
+		}
+		pop(head_, size);
+	}
+
+	void move_items_out_(size_t max_size_in_byte, Container& dest)
+	{
+		size_t size = 0;
+		auto head_ = head.load(std::memory_order_relaxed);
+		for (; size < max_size_in_byte && available(head_); ++head_)
+		{
+			size += at(head_).size();
+			dest.emplace_back(std::move(at(head_)));
+		}
+		pop(head_, size);
+	}
+
+	template<typename _Predicate>
+	void do_something_to_all_(const _Predicate& __pred) {do_something_to_one_([&](reference item) {__pred(item); return false;});}
+
+	template<typename _Predicate> void do_something_to_one_(const _Predicate& __pred)
+	{
+		for (auto head_ = head.load(std::memory_order_relaxed); available(head_); ++head_)
+			if (__pred(at(head_)))
+				return;
+	}
+
+private:
+	struct dummy_container {template<typename T> void emplace_back(T&& item) {}};
+	static size_t round_up(size_t capacity_) {size_t size = 16; while (size < capacity_) size <<= 1; return size;}
+
+	value_type& at(size_t index) {return items[index & (capacity - 1)];}
+
+	//the producer, only reload the head index if the cached one says the queue is full
+	bool has_room(size_t tail_) {return tail_ - head_cache < capacity || tail_ - (head_cache = head.load(std::memory_order_acquire)) < capacity;}
+	template<typename T> void push(size_t tail_, T&& item)
+	{
+		auto size = item.size();
+		new (&at(tail_)) value_type(std::forward<T>(item));
+		in_size.store(in_size.load(std::memory_order_relaxed) + size, std::memory_order_relaxed); //published by the following tail.store
+	}
+
+	//the consumer, only reload the tail index if the cached one says the queue is empty
+	bool available(size_t head_) {return head_ != tail_cache || head_ != (tail_cache = tail.load(std::memory_order_acquire));}
+	void pop(size_t new_head, size_t size)
+	{
+		auto head_ = head.load(std::memory_order_relaxed);
+		if (head_ == new_head)
+			return;
+
+		for (; head_ != new_head; ++head_)
+			at(head_).~value_type();
+		out_size.store(out_size.load(std::memory_order_relaxed) + size, std::memory_order_release);
+		head.store(new_head, std::memory_order_release);
+	}
+
+private:
+	const size_t capacity; //power of 2
+	value_type* const items;
+	char padding1[64]; //keep the consumer and the producer on different cache lines
+	std::atomic_size_t head, out_size; //written by the consumer
+	size_t tail_cache;
+	char padding2[64];
+	std::atomic_size_t tail, in_size; //written by the producer
+	size_t head_cache;
+	char padding3[64];
+};
+
+//bounded queues (like spsc_queue) can be full, others never (unless memory exhausted), call them with 0 as the second parameter.
+template<typename Queue> auto is_full(const Queue& queue, int) -> decltype(queue.full()) {return queue.full();}
+template<typename Queue> bool is_full(const Queue& queue, long) {return false;}
+
+//bounded single producer and single consumer channel of batches, it's lock-free, each slot holds a batch (std::list<T>) which is spliced in
+// and out, so neither side allocates memory nor blocks, the consumer takes all available batches at once.
+//it's used by sync message receiving (see macro ASCS_SYNC_RECV_CHANNEL), handle_msg (in rw_strand) is the only producer and sync_recv_msg
+// is the only consumer.
+template<typename T, size_t Capacity>
+class spsc_channel
+{
+public:
+	static_assert(Capacity > 0 && 0 == (Capacity & (Capacity - 1)), "the capacity of spsc_channel must be power of 2.");
+
+	spsc_channel() : head(0), tail(0) {}
+
+	//any thread
+	size_t size() const {return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);}
+	bool empty() const {return 0 == size();}
+	bool full() const {return size() >= Capacity;}
+
+	//the producer, batch will be empty after pushed
+	bool push(std::list<T>& batch)
+	{
+		auto tail_ = tail.load(std::memory_order_relaxed);
+		if (tail_ - head.load(std::memory_order_acquire) >= Capacity)
+			return false;
+
+		auto& slot = slots[tail_ & (Capacity - 1)];
+		slot.splice(std::end(slot), batch);
+		tail.store(tail_ + 1, std::memory_order_release);
+		return true;
+	}
+
+	//the consumer, append all available batches to dest, return how many batches have been taken
+	size_t pop_all(std::list<T>& dest)
+	{
+		auto head_ = head.load(std::memory_order_relaxed);
+		auto tail_ = tail.load(std::memory_order_acquire);
+		for (auto i = head_; i != tail_; ++i)
+		{
+			auto& slot = slots[i & (Capacity - 1)];
+			dest.splice(std::end(dest), slot);
+		}
+		head.store(tail_, std::memory_order_release);
+
+		return tail_ - head_;
+	}
+
+	//neither the producer nor the consumer is working
+	void clear() {for (auto& slot : slots) slot.clear(); head = tail = 0;}
+
+private:
+	std::list<T> slots[Capacity];
+	char padding1[64]; //keep the consumer and the producer on different cache lines
+	std::atomic_size_t head; //consumer side
+	char padding2[64];
+	std::atomic_size_t tail; //producer side
+};
+
+//multiple lanes queue, each lane is a queue (without lock) and all of them are protected by one Lockable, items which have no lane
+// go to lane 0 (prior items go to its front), items with a lane (see struct lane) go to the back of that lane.
+//items are fetched (try_dequeue and move_items_out) from lanes according to the scheduling policy:
+// STRICT: always fetch from the non-empty lane which has the smallest id (the highest priority), lower lanes may starve.
+// WEIGHTED: deficit round robin, each lane can fetch its quantum (in bytes) of items in its turn (may exceed the quantum by at most
+//  one item), so lower lanes get their share too, the quantum of lane n is (LaneNum - n) * ASCS_LANE_QUANTUM by default.
+//so do_send_msg fills each batch of messages from lanes by the policy, and heartbeats or control messages will not be blocked by
+// a big backlog of bulk messages (if they use different lanes).
+template<typename Container, typename Lockable, size_t LaneNum>
+class lane_queue : public Lockable
+{
+private:
+	typedef queue<Container, dummy_lockable> lane_type;
+
+public:
+	typedef typename Container::value_type value_type;
+	typedef typename Container::size_type size_type;
+	typedef typename Container::reference reference;
+	typedef typename Container::const_reference const_reference;
+
+	enum schedule_policy {STRICT, WEIGHTED};
+	static const size_t lane_num = LaneNum;
+
+	lane_queue() : policy(STRICT), cur_lane(0) {for (size_t i = 0; i < LaneNum; ++i) {quantum[i] = (LaneNum - i) * ASCS_LANE_QUANTUM; deficit[i] = 0;}}
+	lane_queue(size_t capacity) : lane_queue() {}
+
+	//thread safe
+	bool is_thread_safe() const {return Lockable::is_lockable();}
+	size_t size_in_byte() const {size_t size = 0; for (auto& item : lanes) size += item.size_in_byte(); return size;}
+	size_t size_in_byte(const lane& l) const {assert(l.id < LaneNum); return lanes[l.id].size_in_byte();}
+	bool empty() const {for (auto& item : lanes) if (!item.empty()) return false; return true;}
+	bool empty(const lane& l) const {assert(l.id < LaneNum); return lanes[l.id].empty();}
+
+	void set_policy(schedule_policy policy_) {typename Lockable::lock_guard lock(*this); policy = policy_;}
+	schedule_policy get_policy() const {return policy;}
+	void set_quantum(const lane& l, size_t quantum_) {assert(l.id < LaneNum); typename Lockable::lock_guard lock(*this); quantum[l.id] = std::max(quantum_, (size_t) 1);}
+	size_t get_quantum(const lane& l) const {assert(l.id < LaneNum); return quantum[l.id];}
+
+	void clear() {typename Lockable::lock_guard lock(*this); for (auto& item : lanes) item.clear(); reset_deficit();}
+	//items in can will be put into lane 0
+	void swap(Container& can)
+	{
+		Container temp;
+		temp.swap(can);
+
+		typename Lockable::lock_guard lock(*this);
+		move_items_out_(can);
+		lanes[0].move_items_in_(temp);
+	}
+
+	template<typename T> bool enqueue(T&& item) {typename Lockable::lock_guard lock(*this); return enqueue_(std::forward<T>(item));}
+	template<typename T> bool enqueue(T&& item, const lane& l) {typename Lockable::lock_guard lock(*this); return enqueue_(std::forward<T>(item), l);}
+	void move_items_in(Container& src, size_t size_in_byte = 0) {typename Lockable::lock_guard lock(*this); move_items_in_(src, size_in_byte);}
+	void move_items_in(Container& src, const lane& l, size_t size_in_byte = 0) {typename Lockable::lock_guard lock(*this); move_items_in_(src, l, size_in_byte);}
+	template<typename T> bool enqueue_front(T&& item) {typename Lockable::lock_guard lock(*this); return enqueue_front_(std::forward<T>(item));}
+	void move_items_in_front(Container& src, size_t size_in_byte = 0) {typename Lockable::lock_guard lock(*this); move_items_in_front_(src, size_in_byte);}
+	bool try_dequeue(reference item) {typename Lockable::lock_guard lock(*this); return try_dequeue_(item);}
+	void move_items_out(Container& dest, size_t max_item_num = -1) {typename Lockable::lock_guard lock(*this); move_items_out_(dest, max_item_num);}
+	void move_items_out(size_t max_size_in_byte, Container& dest) {typename Lockable::lock_guard lock(*this); move_items_out_(max_size_in_byte, dest);}
+	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred) {typename Lockable::lock_guard lock(*this); do_something_to_all_(__pred);}
+	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred) {typename Lockable::lock_guard lock(*this); do_something_to_one_(__pred);}
+	//thread safe
+
+	//not thread safe
+	template<typename T> bool enqueue_(T&& item) {return lanes[0].enqueue_(std::forward<T>(item));}
+	template<typename T> bool enqueue_(T&& item, const lane& l) {assert(l.id < LaneNum); return lanes[l.id].enqueue_(std::forward<T>(item));}
+	void move_items_in_(Container& src, size_t size_in_byte = 0) {lanes[0].move_items_in_(src, size_in_byte);}
+	void move_items_in_(Container& src, const lane& l, size_t size_in_byte = 0) {assert(l.id < LaneNum); lanes[l.id].move_items_in_(src, size_in_byte);}
+	template<typename T> bool enqueue_front_(T&& item) {return lanes[0].enqueue_front_(std::forward<T>(item));}
+	void move_items_in_front_(Container& src, size_t size_in_byte = 0) {lanes[0].move_items_in_front_(src, size_in_byte);}
+
+	bool try_dequeue_(reference item)
+	{
+		auto index = next_lane();
+		if (LaneNum == index || !lanes[index].try_dequeue_(item))
+			return false;
+
+		consume(index, item.size());
+		return true;
+	}
+
+	void move_items_out_(Container& dest, size_t max_item_num = -1)
+	{
+		if ((size_t) -1 == max_item_num) //all items, priority doesn't matter
+		{
+			for (auto& item : lanes)
+				item.move_items_out_(dest);
+			reset_deficit();
+		}
+		else
+			for (size_t index; max_item_num > 0 && LaneNum != (index = next_lane()); --max_item_num)
+				consume(index, fetch(index, 0, dest)); //one item
+	}
+
+	void move_items_out_(size_t max_size_in_byte, Container& dest)
+	{
+		if ((size_t) -1 == max_size_in_byte)
+			return move_items_out_(dest);
+
+		size_t size = 0; //at least one item (if available) even max_size_in_byte is zero, just like queue
+		for (size_t index; (0 == size || size < max_size_in_byte) && LaneNum != (index = next_lane());)
+		{
+			auto budget = max_size_in_byte - size;
+			if (WEIGHTED == policy)
+				budget = std::min(budget, deficit[index]);
+
+			auto fetched_size = fetch(index, budget, dest);
+			consume(index, fetched_size);
+			size += fetched_size;
+		}
+	}
+
+	template<typename _Predicate> void do_something_to_all_(const _Predicate& __pred) {for (auto& item : lanes) item.do_something_to_all_(__pred);}
+	template<typename _Predicate> void do_something_to_all_(const _Predicate& __pred) const {for (auto& item : lanes) item.do_something_to_all_(__pred);}
+
+	template<typename _Predicate> void do_something_to_one_(const _Predicate& __pred)
+	{
+		auto found = false;
+		for (auto iter = std::begin(lanes); !found && iter != std::end(lanes); ++iter)
+			iter->do_something_to_one_([&](reference item) {return found = __pred(item);});
+	}
+	//not thread safe
+
+private:
+	//return the lane which should be fetched, LaneNum means all lanes are empty
+	size_t next_lane()
+	{
+		if (STRICT == policy)
+		{
+			for (size_t i = 0; i < LaneNum; ++i)
+				if (!lanes[i].empty())
+					return i;
+
+			return LaneNum;
+		}
+
+		for (size_t i = 0; i < LaneNum; ++i, cur_lane = (cur_lane + 1) % LaneNum)
+			if (lanes[cur_lane].empty())
+				deficit[cur_lane] = 0; //empty lane doesn't accumulate its deficit
+			else
+			{
+				if (0 == deficit[cur_lane]) //a new turn
+					deficit[cur_lane] = quantum[cur_lane];
+				return cur_lane;
+			}
+
+		return LaneNum;
+	}
+
+	void consume(size_t index, size_t size)
+	{
+		if (WEIGHTED == policy && (deficit[index] = size >= deficit[index] ? 0 : deficit[index] - size) == 0)
+			cur_lane = (index + 1) % LaneNum; //turn to the next lane
+	}
+
+	size_t fetch(size_t index, size_t max_size_in_byte, Container& dest)
+	{
+		auto size = lanes[index].size_in_byte();
+		lanes[index].move_items_out_(max_size_in_byte, dest);
+		return size - lanes[index].size_in_byte();
+	}
+
+	void reset_deficit() {for (auto& item : deficit) item = 0; cur_lane = 0;}
+
+private:
+	lane_type lanes[LaneNum];
+	schedule_policy policy;
+	size_t quantum[LaneNum], deficit[LaneNum], cur_lane;
+};
+
+//conflating queue, for feeds which only care about the latest value of each key (market data for example), a new item whose key
+// already exists in the queue replaces the queued one in place (so the freshest value will be sent at the queued position, and the
+// replaced one is dropped), so the queue holds at most one item per key, and slow consumers will not build an unbounded backlog.
+//KeyExtractor must provide:
+// typedef ... key_type; //must be hashable (by Hash)
+// bool operator()(const value_type& item, key_type& key) const; //return false if the item has no key (never be conflated)
+//key_type must be default constructible.
+//items are put into a pooled_list and indexed by a hash map, Container is just used to transfer items in and out.
+//prior items (enqueue_front and move_items_in_front) go to the front, if their keys exist, the old items will be dropped.
+//a replaced item will never be sent, if it carries a completion (sync_send_msg or msgs sent with a completion), it will be completed with
+// NOT_APPLICABLE (after the lock been released, except in the not thread safe functions).
+template<typename Container, typename KeyExtractor, typename Lockable = lockable, typename Hash = std::hash<typename KeyExtractor::key_type>>
+class conflating_queue : public Lockable
+{
+public:
+	typedef typename Container::value_type value_type;
+	typedef typename Container::size_type size_type;
+	typedef typename Container::reference reference;
+	typedef typename Container::const_reference const_reference;
+	typedef typename KeyExtractor::key_type key_type;
+
+private:
+	struct unit
+	{
+		template<typename T> unit(T&& item_) : item(std::forward<T>(item_)), key(nullptr) {}
+
+		value_type item;
+		const key_type* key; //points to the key in the index, nullptr means no key
+	};
+	typedef pooled_list<unit> unit_list;
+	typedef std::unordered_map<key_type, typename unit_list::iterator, Hash> unit_index;
+
+public:
+	conflating_queue() : total_size(0), conflated_num(0), conflated_size(0) {}
+	conflating_queue(size_t capacity) : conflating_queue() {index.reserve(capacity);}
+
+	//thread safe
+	bool is_thread_safe() const {return Lockable::is_lockable();}
+	size_t size_in_byte() const {return total_size;}
+	bool empty() const {return units.empty();}
+	//how many items (and bytes) have been dropped because of conflation
+	uint_fast64_t conflated_msg_num() const {return conflated_num;}
+	uint_fast64_t conflated_size_in_byte() const {return conflated_size;}
+
+	void clear() {typename Lockable::lock_guard lock(*this); units.clear(); index.clear(); total_size = 0;}
+	void swap(Container& can)
+	{
+		Container temp;
+		temp.swap(can);
+
+		locked_insert([&]() {this->move_items_out_(can); this->do_move_items_in(temp); return true;});
+	}
+
+	template<typename T> bool enqueue(T&& item) {return locked_insert([&]() {return this->do_enqueue(std::forward<T>(item));});}
+	void move_items_in(Container& src, size_t size_in_byte = 0) {locked_insert([&]() {this->do_move_items_in(src); return true;});}
+	template<typename T> bool enqueue_front(T&& item) {return locked_insert([&]() {return this->do_enqueue_front(std::forward<T>(item));});}
+	void move_items_in_front(Container& src, size_t size_in_byte = 0) {locked_insert([&]() {this->do_move_items_in_front(src); return true;});}
+	bool try_dequeue(reference item) {typename Lockable::lock_guard lock(*this); return try_dequeue_(item);}
+	void move_items_out(Container& dest, size_t max_item_num = -1) {typename Lockable::lock_guard lock(*this); move_items_out_(dest, max_item_num);}
+	void move_items_out(size_t max_size_in_byte, Container& dest) {typename Lockable::lock_guard lock(*this); move_items_out_(max_size_in_byte, dest);}
+	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred) {typename Lockable::lock_guard lock(*this); do_something_to_all_(__pred);}
+	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred) {typename Lockable::lock_guard lock(*this); do_something_to_one_(__pred);}
+	//thread safe
+
+	//not thread safe
+	template<typename T> bool enqueue_(T&& item) {auto re = do_enqueue(std::forward<T>(item)); complete_replaced(replaced_items); return re;}
+	void move_items_in_(Container& src, size_t size_in_byte = 0) {do_move_items_in(src); complete_replaced(replaced_items);}
+	template<typename T> bool enqueue_front_(T&& item) {auto re = do_enqueue_front(std::forward<T>(item)); complete_replaced(replaced_items); return re;}
+	void move_items_in_front_(Container& src, size_t size_in_byte = 0) {do_move_items_in_front(src); complete_replaced(replaced_items);}
+
+	bool try_dequeue_(reference item) {if (units.empty()) return false; item.swap(units.front().item); pop_front(item.size()); return true;}
+
+	void move_items_out_(Container& dest, size_t max_item_num = -1)
+	{
+		for (; max_item_num > 0 && !units.empty(); --max_item_num)
+		{
+			auto size = units.front().item.size();
+			dest.emplace_back(std::move(units.front().item));
+			pop_front(size);
+		}
+	}
+
+	void move_items_out_(size_t max_size_in_byte, Container& dest)
+	{
+		size_t size = 0; //at least one item (if available) even max_size_in_byte is zero, just like queue
+		while (!units.empty())
+		{
+			auto item_size = units.front().item.size();
+			dest.emplace_back(std::move(units.front().item));
+			pop_front(item_size);
+			if ((size += item_size) >= max_size_in_byte)
+				break;
+		}
+	}
+
+	template<typename _Predicate> void do_something_to_all_(const _Predicate& __pred) {for (auto& item : units) __pred(item.item);}
+	template<typename _Predicate> void do_something_to_all_(const _Predicate& __pred) const {for (auto& item : units) __pred(item.item);}
+
+	template<typename _Predicate>
+	void do_something_to_one_(const _Predicate& __pred) {for (auto iter = units.begin(); iter != units.end(); ++iter) if (__pred(iter->item)) break;}
+	template<typename _Predicate>
+	void do_something_to_one_(const _Predicate& __pred) const {for (auto iter = units.begin(); iter != units.end(); ++iter) if (__pred(iter->item)) break;}
+	//not thread safe
+
+private:
+	//insert items under the lock, and complete replaced items after the lock been released
+	template<typename F> bool locked_insert(const F& f)
+	{
+		Container replaced;
+		bool re;
+		{
+			typename Lockable::lock_guard lock(*this);
+			re = f();
+			replaced.swap(replaced_items);
+		}
+		complete_replaced(replaced);
+
+		return re;
+	}
+
+	static void complete_replaced(Container& can) {if (!can.empty()) {ascs::complete_dropped_items(can); can.clear();}}
+
+	template<typename T> bool do_enqueue(T&& item) {return insert(units.end(), std::forward<T>(item));}
+	void do_move_items_in(Container& src) {for (auto& item : src) do_enqueue(std::move(item)); src.clear();}
+	template<typename T> bool do_enqueue_front(T&& item) {return insert(units.begin(), std::forward<T>(item));}
+	void do_move_items_in_front(Container& src)
+	{
+		auto pos = units.begin();
+		for (auto& item : src)
+			insert(pos, std::move(item)); //keep the order of items in src
+		src.clear();
+	}
+
+	//pos is units.end() for normal items, otherwise for prior items
+	template<typename T> bool insert(typename unit_list::iterator pos, T&& item)
+	{
+		try
+		{
+			auto size = item.size();
+			key_type key;
+			if (!extractor(item, key))
+				units.emplace(pos, std::forward<T>(item));
+			else
+			{
+				auto iter = index.find(key);
+				if (index.end() == iter)
+				{
+					auto unit_iter = units.emplace(pos, std::forward<T>(item));
+					unit_iter->key = &index.emplace(std::move(key), unit_iter).first->first;
+				}
+				else
+				{
+					auto unit_iter = iter->second;
+					auto old_size = unit_iter->item.size();
+					replaced_items.emplace_back(std::move(unit_iter->item));
+					unit_iter->item = std::forward<T>(item);
+					if (units.end() != pos) //prior item, move it to the front, otherwise in place
+						units.splice(pos, units, unit_iter);
+
+					++conflated_num;
+					conflated_size += old_size;
+					total_size -= old_size;
+				}
+			}
+
+			total_size += size;
+		}
+		catch (const std::exception& e)
+		{
+			unified_out::error_out("cannot hold more objects (%s)", e.what());
+			return false;
+		}
+
+		return true;
+	}
+
+	void pop_front(size_t size)
+	{
+		if (nullptr != units.front().key)
+			index.erase(*units.front().key);
+		units.pop_front();
+		total_size -= size;
+	}
+
+private:
+	unit_list units;
+	unit_index index;
+	Container replaced_items; //replaced by new items, will be completed soon
+	KeyExtractor extractor;
+	size_t total_size;
+	uint_fast64_t conflated_num, conflated_size;
+};
+
 //ascs requires that queue must take one and only one template argument
 template<typename Container> using non_lock_queue = queue<Container, dummy_lockable>; //thread safety depends on Container
 template<typename Container> using lock_queue = queue<Container, lockable>;
+template<typename Container> using lock_free_queue = mpsc_queue<Container, lockable>; //only producers are lock-free, see mpsc_queue for more details
+template<typename Container> using multi_lane_queue = lane_queue<Container, lockable, ASCS_LANE_NUM>;
 
 } //namespace
 
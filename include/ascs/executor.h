@@ -45,6 +45,7 @@ public:
 	template<typename F> void dispatch_strand(asio::io_context::strand& strand, F&& handler) {strand.dispatch(std::forward<F>(handler));}
 #endif
 
+	template<typename F> inline F&& make_handler(F&& f) const {return std::forward<F>(f);}
 	template<typename F> inline F&& make_handler_error(F&& f) const {return std::forward<F>(f);}
 	template<typename F> inline F&& make_handler_error_size(F&& f) const {return std::forward<F>(f);}
 
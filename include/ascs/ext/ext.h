@@ -39,6 +39,10 @@
 #endif
 
 #define ASCS_HEAD_LEN	(sizeof(ASCS_HEAD_TYPE))
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+//credit frame: a head of 0 (which is invalid for normal msgs) followed by an 8 bytes big-endian credit edge, see macro ASCS_CREDIT_FLOW_CONTROL.
+#define ASCS_CREDIT_FRAME_LEN	(ASCS_HEAD_LEN + 8)
+#endif
 static_assert(100 * 1024 * 1024 >= ASCS_MSG_BUFFER_SIZE && ASCS_MSG_BUFFER_SIZE >= ASCS_HEAD_LEN, "invalid message buffer size.");
 
 namespace ascs { namespace ext {
@@ -53,6 +53,15 @@ public:
 
 		return ASCS_HEAD_H2N(head_len);
 	}
+
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	static void pack_credit(char* buff, uint_fast64_t edge) //buff must be able to hold ASCS_CREDIT_FRAME_LEN bytes
+	{
+		memset(buff, 0, ASCS_HEAD_LEN);
+		for (auto i = ASCS_CREDIT_FRAME_LEN - 1; i >= ASCS_HEAD_LEN; --i, edge >>= 8)
+			buff[i] = (char) (edge & 0xff);
+	}
+#endif
 };
 
 //protocol: length + body
@@ -135,6 +144,10 @@ public:
 		return true;
 	}
 	virtual typename super::msg_type pack_heartbeat() {auto head_len = packer_helper::pack_header(0); return typename super::msg_type((const char*) &head_len, ASCS_HEAD_LEN);}
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	virtual typename super::msg_type pack_credit(uint_fast64_t edge)
+		{char buff[ASCS_CREDIT_FRAME_LEN]; packer_helper::pack_credit(buff, edge); return typename super::msg_type(buff, ASCS_CREDIT_FRAME_LEN);}
+#endif
 
 	//msg must has been packed by this packer with native == false
 	virtual char* raw_data(typename super::msg_type& msg) const {return const_cast<char*>(std::next(msg.data(), ASCS_HEAD_LEN));}
@@ -213,6 +226,15 @@ public:
 		raw_msg->swap(str);
 		return typename super::msg_type(raw_msg);
 	}
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	virtual typename super::msg_type pack_credit(uint_fast64_t edge)
+	{
+		auto raw_msg = new T();
+		auto str = Packer().pack_credit(edge);
+		raw_msg->swap(str);
+		return typename super::msg_type(raw_msg);
+	}
+#endif
 
 	//msg must has been packed by this packer with native == false
 	virtual char* raw_data(typename super::msg_type& msg) const {return const_cast<char*>(std::next(msg.data(), ASCS_HEAD_LEN));}
@@ -220,6 +242,10 @@ public:
 	virtual size_t raw_data_len(typename super::msg_ctype& msg) const {return msg.size() - ASCS_HEAD_LEN;}
 };
 
+//packed messages are reference-counted and immutable, copying them only increases the reference count, so it's the best choice for
+// shared_broadcast_msg (all sockets share the same bytes), see macro TCP_SHARED_BROADCAST_MSG for more details.
+template<typename Packer = packer<>> using shared_packer = packer2<shared_buffer<i_buffer>, string_buffer, Packer>;
+
 //protocol: fixed length
 class fixed_length_packer : public packer<>
 {
@@ -229,7 +255,10 @@ public:
 	virtual bool pack_msg(msg_type&& msg, container_type& msg_can) {msg_can.emplace_back(std::move(msg)); return true;}
 	virtual bool pack_msg(msg_type&& msg1, msg_type&& msg2, container_type& msg_can) {msg_can.emplace_back(std::move(msg1)); msg_can.emplace_back(std::move(msg2)); return true;}
 	virtual bool pack_msg(container_type& in, container_type& out) {in.swap(out); return true;}
-	//not support heartbeat because fixed_length_unpacker cannot recognize heartbeat message
+	//not support heartbeat and credit frames because fixed_length_unpacker cannot recognize them
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	virtual msg_type pack_credit(uint_fast64_t edge) {return msg_type();}
+#endif
 };
 
 //protocol: [prefix] + body + suffix
@@ -46,6 +46,27 @@ public:
 			unified_out::error_out("unparsed data (current msg length is: " ASCS_SF ") are:\n%s", cur_msg_len, os.str().data());
 		}
 	}
+
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	static bool is_credit_frame(const char* data, size_t len)
+	{
+		if (ASCS_CREDIT_FRAME_LEN != len)
+			return false;
+
+		ASCS_HEAD_TYPE head;
+		memcpy(&head, data, ASCS_HEAD_LEN);
+		return 0 == head;
+	}
+
+	static uint_fast64_t unpack_credit(const char* data) //data must hold an entire credit frame
+	{
+		uint_fast64_t edge = 0;
+		for (auto i = ASCS_HEAD_LEN; i < ASCS_CREDIT_FRAME_LEN; ++i)
+			edge = (edge << 8) + (unsigned char) data[i];
+
+		return edge;
+	}
+#endif
 };
 
 //protocol: length + body
@@ -67,6 +88,20 @@ public:
 		while (unpack_ok) //considering sticky package problem, we need a loop
 			if ((size_t) -1 != cur_msg_len)
 			{
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+				if (0 == cur_msg_len) //credit frame, it's also returned via msg_can (to keep the offset of left behind data), parse_msg will filter it
+				{
+					if (remain_len < ASCS_CREDIT_FRAME_LEN)
+						break;
+
+					peer_edge = std::max(peer_edge, unpacker_helper::unpack_credit(pnext));
+					msg_can.emplace_back(pnext, ASCS_CREDIT_FRAME_LEN);
+					remain_len -= ASCS_CREDIT_FRAME_LEN;
+					std::advance(pnext, ASCS_CREDIT_FRAME_LEN);
+					cur_msg_len = -1;
+				}
+				else
+#endif
 				if (cur_msg_len > ASCS_MSG_BUFFER_SIZE || cur_msg_len < ASCS_HEAD_LEN)
 					unpack_ok = false;
 				else if (remain_len >= cur_msg_len) //one msg received
@@ -99,7 +134,13 @@ public:
 	}
 
 public:
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	virtual void reset() {cur_msg_len = -1; remain_len = 0; peer_edge = 0;}
+	virtual uint_fast64_t credit_edge() const {return peer_edge;}
+	virtual bool supports_credit() const {return true;}
+#else
 	virtual void reset() {cur_msg_len = -1; remain_len = 0;}
+#endif
 	virtual void dump_left_data() const {unpacker_helper::dump_left_data(raw_buff.data(), cur_msg_len, remain_len);}
 	virtual bool parse_msg(size_t bytes_transferred, typename super::container_type& msg_can)
 	{
@@ -110,7 +151,11 @@ public:
 		std::list<std::pair<const char*, size_t>> msg_pos_can;
 		auto unpack_ok = parse_msg(msg_pos_can);
 		do_something_to_all(msg_pos_can, [this, &msg_can](decltype(msg_pos_can.front()) item) {
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+			if (item.second > ASCS_HEAD_LEN && !unpacker_helper::is_credit_frame(item.first, item.second)) //ignore heartbeat and credit frame
+#else
 			if (item.second > ASCS_HEAD_LEN) //ignore heartbeat
+#endif
 			{
 				if (this->stripped())
 					msg_can.emplace_back(std::next(item.first, ASCS_HEAD_LEN), item.second - ASCS_HEAD_LEN);
@@ -145,10 +190,18 @@ public:
 			ASCS_HEAD_TYPE head;
 			memcpy(&head, &*std::begin(raw_buff), ASCS_HEAD_LEN);
 			cur_msg_len = ASCS_HEAD_N2H(head);
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+			if (0 != cur_msg_len && (cur_msg_len > ASCS_MSG_BUFFER_SIZE || cur_msg_len < ASCS_HEAD_LEN)) //invalid msg, stop reading
+#else
 			if (cur_msg_len > ASCS_MSG_BUFFER_SIZE || cur_msg_len < ASCS_HEAD_LEN) //invalid msg, stop reading
+#endif
 				return 0;
 		}
 
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+		if (0 == cur_msg_len) //credit frame
+			return data_len >= ASCS_CREDIT_FRAME_LEN ? 0 : ASCS_MSG_BUFFER_SIZE;
+#endif
 		return data_len >= cur_msg_len ? 0 : ASCS_MSG_BUFFER_SIZE;
 		//read as many as possible except that we have already got an entire msg
 	}
@@ -172,6 +225,9 @@ protected:
 	std::array<char, ASCS_MSG_BUFFER_SIZE> raw_buff;
 	size_t cur_msg_len; //-1 means head not received, so msg length is not available.
 	size_t remain_len; //half-baked msg
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	uint_fast64_t peer_edge; //the biggest credit edge received
+#endif
 };
 
 //protocol: length + body
@@ -292,7 +348,7 @@ public:
 			return 0;
 
 		auto data_len = remain_len + bytes_transferred;
-		assert(data_len <= cur_msg_len);
+		assert(data_len <= (big_msg.empty() ? raw_buff.size() : big_msg.size())); //more than one msg can be read at a time
 
 		if ((size_t) -1 == cur_msg_len && data_len >= ASCS_HEAD_LEN) //the msg's head been received
 		{
@@ -402,6 +458,8 @@ public:
 
 	virtual void reset() {unpacker_.reset();}
 	virtual void dump_left_data() const {unpacker_.dump_left_data();}
+	virtual uint_fast64_t credit_edge() const {return unpacker_.credit_edge();}
+	virtual bool supports_credit() const {return unpacker_.supports_credit();}
 	virtual bool parse_msg(size_t bytes_transferred, typename super::container_type& msg_can)
 	{
 		typename Unpacker::container_type tmp_can;
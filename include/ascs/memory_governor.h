@@ -0,0 +1,219 @@
+/*
+ * memory_governor.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: ascs contributors
+ *
+ * global memory budget of sockets
+ */
+
+#ifndef _ASCS_MEMORY_GOVERNOR_H_
+#define _ASCS_MEMORY_GOVERNOR_H_
+
+#include <unordered_set>
+
+#include "base.h"
+
+namespace ascs
+{
+
+//a consumer of the global memory budget, ascs::socket implements it, all functions must be thread safe, because the policy is enforced
+// in whichever thread charged the budget (see memory_governor::charge), it can be a service thread, a dispatching thread or a user's thread
+// who is sending msgs, so shed_send_msgs and pause_recv_by_governor can be called in any thread (and concurrently with the consumer's strands).
+//a consumer must call del_consumer before it's being destroyed (not in the destructor of a base class), del_consumer waits for the
+// enforcement which is calling it, ascs::socket removes itself from the governor when it's closed and adds itself back when it's started.
+class i_memory_consumer
+{
+public:
+	virtual uint_fast64_t mem_consumer_id() const = 0;
+	virtual size_t send_mem_usage() const = 0; //bytes in the sending buffer
+	virtual size_t recv_mem_usage() const = 0; //bytes in the receiving buffer
+	virtual size_t shed_send_msgs() = 0; //drop all msgs in the sending buffer, return how many bytes have been dropped
+	virtual void pause_recv_by_governor(bool pause) = 0; //suspend message receiving or resume it
+};
+
+//sockets charge their sending and receiving buffers (msgs which have been moved into them, not msgs being sent or dispatched) against
+// the governor, when the usage reaches the high watermark, the budget is exhausted and the policy takes effect, until the usage falls
+// to the low watermark, then the budget recovers and all consumers will be resumed (see ascs::socket::resume_recv).
+//service_pump owns one (see service_pump::get_memory_governor), bind sockets to it via ascs::object_pool::mem_governor or
+// ascs::socket::mem_governor, all functions are thread safe.
+class memory_governor
+{
+public:
+	enum class policy
+	{
+		REJECT, //msg sending fails (except can_overflow) and message receiving is suspended on all sockets
+		SHED_LARGEST, //drop pending msgs of the sockets who have the biggest sending buffers, until the usage falls to the low watermark
+		PAUSE_TOP_N, //suspend message receiving on top_n sockets who have the biggest receiving buffers (more will be suspended if the usage keeps growing)
+	};
+
+	struct consumer_usage
+	{
+		consumer_usage(uint_fast64_t id_ = -1, size_t send_size_ = 0, size_t recv_size_ = 0) : id(id_), send_size(send_size_), recv_size(recv_size_) {}
+		size_t total() const {return send_size + recv_size;}
+
+		uint_fast64_t id;
+		size_t send_size, recv_size;
+	};
+
+	struct governor_statistic
+	{
+		governor_statistic() : usage(0), peak_usage(0), exhausted_num(0), shed_byte_sum(0), paused_num(0) {}
+
+		std::string to_string() const
+		{
+			std::ostringstream s;
+			s << "usage: " << usage << std::endl << "peak usage: " << peak_usage << std::endl << "exhausted times: " << exhausted_num
+				<< std::endl << "shed bytes: " << shed_byte_sum << std::endl << "paused sockets: " << paused_num;
+			return s.str();
+		}
+
+		size_t usage, peak_usage;
+		uint_fast64_t exhausted_num;
+		uint_fast64_t shed_byte_sum;
+		uint_fast64_t paused_num; //times of socket pausing, not the number of sockets being paused
+	};
+
+	memory_governor() : policy_(policy::REJECT), top_n_(ASCS_MEM_GOVERNOR_TOP_N), high_watermark_(0), low_watermark_(0),
+		used(0), peak(0), next_enforcing_usage(0), exhausted_num(0), shed_byte_sum(0), paused_num(0), exhausted(false) {enforcing.clear(std::memory_order_relaxed);}
+
+	//0 high watermark (the default) means no limitation, low watermark will be adjusted to not bigger than the high watermark.
+	void watermarks(size_t high, size_t low) {high_watermark_ = high; low_watermark_ = std::min(low, high);}
+	size_t high_watermark() const {return high_watermark_;}
+	size_t low_watermark() const {return low_watermark_;}
+
+	void governing_policy(policy p, size_t top_n = ASCS_MEM_GOVERNOR_TOP_N) {policy_ = p; top_n_ = std::max(top_n, (size_t) 1);}
+	policy governing_policy() const {return policy_;}
+	size_t top_n() const {return top_n_;}
+
+	size_t usage() const {return used;}
+	bool is_exhausted() const {return exhausted;}
+	//sockets check this before msg sending and receiving.
+	bool is_rejecting() const {return exhausted && policy::REJECT == policy_.load(std::memory_order_relaxed);}
+
+	governor_statistic get_statistic() const
+	{
+		governor_statistic stat;
+		stat.usage = used;
+		stat.peak_usage = peak;
+		stat.exhausted_num = exhausted_num;
+		stat.shed_byte_sum = shed_byte_sum;
+		stat.paused_num = paused_num;
+
+		return stat;
+	}
+
+	//per-socket usage, sorted by total usage (biggest first)
+	std::vector<consumer_usage> get_consumer_usage() const
+	{
+		std::vector<consumer_usage> re;
+		std::lock_guard<std::recursive_mutex> lock(consumer_can_mutex);
+		re.reserve(consumer_can.size());
+		for (auto& item : consumer_can)
+			re.emplace_back(item->mem_consumer_id(), item->send_mem_usage(), item->recv_mem_usage());
+		std::sort(std::begin(re), std::end(re), [](const consumer_usage& left, const consumer_usage& right) {return left.total() > right.total();});
+
+		return re;
+	}
+
+	//called by consumers
+	void add_consumer(i_memory_consumer* consumer) {std::lock_guard<std::recursive_mutex> lock(consumer_can_mutex); consumer_can.insert(consumer);}
+	void del_consumer(i_memory_consumer* consumer)
+	{
+		std::lock_guard<std::recursive_mutex> lock(consumer_can_mutex);
+		consumer_can.erase(consumer);
+		paused_can.erase(consumer);
+	}
+
+	void charge(size_t size)
+	{
+		auto now = used.fetch_add(size, std::memory_order_relaxed) + size;
+		auto peak_ = peak.load(std::memory_order_relaxed);
+		while (now > peak_ && !peak.compare_exchange_weak(peak_, now, std::memory_order_relaxed));
+
+		auto high = high_watermark_.load(std::memory_order_relaxed);
+		if (high > 0 && now >= high)
+		{
+			if (!exhausted && !exhausted.exchange(true))
+			{
+				++exhausted_num;
+				enforce();
+			}
+			else if (now >= next_enforcing_usage) //the usage keeps growing
+				enforce();
+		}
+	}
+
+	void release(size_t size)
+	{
+		auto now = used.fetch_sub(size, std::memory_order_relaxed) - size;
+		if (exhausted && now <= low_watermark_ && exhausted.exchange(false))
+			recover();
+	}
+
+private:
+	//only one thread enforces the policy at a time, others (and consumers who release memory during the enforcement) just skip it,
+	// the policy will be enforced again after the usage grew another (high watermark - low watermark) bytes.
+	void enforce()
+	{
+		if (policy::REJECT == policy_ || enforcing.test_and_set(std::memory_order_acquire))
+			return;
+
+		next_enforcing_usage = used + std::max(high_watermark_ - low_watermark_, (size_t) 1);
+
+		std::lock_guard<std::recursive_mutex> lock(consumer_can_mutex);
+		std::vector<std::pair<size_t, i_memory_consumer*>> candidates;
+		candidates.reserve(consumer_can.size());
+		auto shedding = policy::SHED_LARGEST == policy_;
+		for (auto& item : consumer_can)
+			if (shedding)
+				candidates.emplace_back(item->send_mem_usage(), item);
+			else if (0 == paused_can.count(item))
+				candidates.emplace_back(item->recv_mem_usage(), item);
+		std::sort(std::begin(candidates), std::end(candidates),
+			[](const std::pair<size_t, i_memory_consumer*>& left, const std::pair<size_t, i_memory_consumer*>& right) {return left.first > right.first;});
+
+		if (shedding)
+		{
+			for (auto iter = std::begin(candidates); exhausted && iter != std::end(candidates) && iter->first > 0; ++iter)
+				shed_byte_sum += iter->second->shed_send_msgs(); //release will be called by the consumer, and then may recover the budget
+		}
+		else
+			for (size_t i = 0; i < top_n_ && i < candidates.size() && candidates[i].first > 0; ++i)
+			{
+				paused_can.insert(candidates[i].second);
+				candidates[i].second->pause_recv_by_governor(true);
+				++paused_num;
+			}
+
+		enforcing.clear(std::memory_order_release);
+	}
+
+	void recover()
+	{
+		std::lock_guard<std::recursive_mutex> lock(consumer_can_mutex);
+		if (exhausted) //exhausted again before we got the lock
+			return;
+
+		paused_can.clear();
+		for (auto& item : consumer_can) //with policy REJECT, all sockets can be suspended
+			item->pause_recv_by_governor(false);
+	}
+
+private:
+	std::atomic<policy> policy_;
+	std::atomic_size_t top_n_;
+	std::atomic_size_t high_watermark_, low_watermark_;
+
+	std::atomic_size_t used, peak, next_enforcing_usage;
+	std::atomic<uint_fast64_t> exhausted_num, shed_byte_sum, paused_num;
+	std::atomic_bool exhausted;
+	std::atomic_flag enforcing;
+
+	std::unordered_set<i_memory_consumer*> consumer_can, paused_can;
+	mutable std::recursive_mutex consumer_can_mutex; //enforce and recover call consumers, who may call release (and then recover) in turn
+};
+
+} //namespace
+
+#endif /* _ASCS_MEMORY_GOVERNOR_H_ */
@@ -0,0 +1,665 @@
+/*
+ * object_container.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: ascs contributors
+ *
+ * storages of living objects for object_pool
+ */
+
+#ifndef _ASCS_OBJECT_CONTAINER_H_
+#define _ASCS_OBJECT_CONTAINER_H_
+
+#include <unordered_map>
+
+#include "base.h"
+
+namespace ascs
+{
+
+//object storage (the Container template parameter of object_pool) must satisfy the following interface, all functions must be thread safe:
+//bool add(object_ctype& object_ptr, size_t max_size); //fail if object_ptr->id() already exists or size() >= max_size
+//object_type del(uint_fast64_t id); //return the removed object (null means not exist)
+//bool change_id(object_ctype& object_ptr, uint_fast64_t id); //re-index object_ptr by id (object_ptr->id() is still the old one), fail if id already exists
+//size_t size();
+//bool exist(uint_fast64_t id);
+//object_type find(uint_fast64_t id);
+//object_type at(size_t index);
+//template<typename _Predicate> void do_something_to_all(const _Predicate& __pred);
+//template<typename _Predicate> void do_something_to_one(const _Predicate& __pred); //stop at the first object that __pred returns true
+//template<typename _Predicate> void remove_if(const _Predicate& __pred, std::list<object_type>& objects); //removed objects will be appended to objects
+
+//one std::unordered_map guarded by one ASCS_SHARED_MUTEX_TYPE
+template<typename Object>
+class object_map
+{
+public:
+	typedef std::shared_ptr<Object> object_type;
+	typedef const object_type object_ctype;
+	typedef std::unordered_map<uint_fast64_t, object_type> container_type;
+
+	//to configure unordered_map (for example, set factor or reserved size), not thread safe, so must be called before service_pump startup.
+	container_type& container() {return object_can;}
+
+	bool add(object_ctype& object_ptr, size_t max_size)
+	{
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		return object_can.size() < max_size ? object_can.emplace(object_ptr->id(), object_ptr).second : false;
+	}
+
+	object_type del(uint_fast64_t id)
+	{
+		auto object_ptr = object_type();
+
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		auto iter = object_can.find(id);
+		if (iter != std::end(object_can))
+		{
+			object_ptr = std::move(iter->second);
+			object_can.erase(iter);
+		}
+
+		return object_ptr;
+	}
+
+	bool change_id(object_ctype& object_ptr, uint_fast64_t id)
+	{
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		if (!object_can.emplace(id, object_ptr).second)
+			return false;
+
+		object_can.erase(object_ptr->id());
+		return true;
+	}
+
+	size_t size()
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		return object_can.size();
+	}
+
+	bool exist(uint_fast64_t id)
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		return object_can.count(id) > 0;
+	}
+
+	object_type find(uint_fast64_t id)
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		auto iter = object_can.find(id);
+		return iter != std::end(object_can) ? iter->second : object_type();
+	}
+
+	//this method has linear complexity, please note.
+	object_type at(size_t index)
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		assert(index < object_can.size());
+		return index < object_can.size() ? std::next(std::begin(object_can), index)->second : object_type();
+	}
+
+	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred)
+		{ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex); for (auto& item : object_can) __pred(item.second);}
+
+	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred)
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		for (auto iter = std::begin(object_can); iter != std::end(object_can); ++iter)
+			if (__pred(iter->second))
+				break;
+	}
+
+	template<typename _Predicate> void remove_if(const _Predicate& __pred, std::list<object_type>& objects)
+	{
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		for (auto iter = std::begin(object_can); iter != std::end(object_can);)
+			if (__pred(iter->second))
+			{
+				try {objects.emplace_back(std::move(iter->second));} catch (const std::exception& e) {unified_out::error_out("cannot hold more objects (%s)", e.what());}
+				iter = object_can.erase(iter);
+			}
+			else
+				++iter;
+	}
+
+private:
+	container_type object_can;
+	ASCS_SHARED_MUTEX_TYPE object_can_mutex;
+};
+
+//ShardNum std::unordered_maps, each guarded by its own ASCS_SHARED_MUTEX_TYPE, objects are distributed by the hash of their ids,
+//so add/del/find only lock one shard and readers of other shards will not be blocked by them.
+//size() and max_size accounting are global (an atomic counter), do_something_to_all/one, at and remove_if walk the shards one by one,
+//which means they don't see an atomic view of all objects (objects added or deleted during the iteration may or may not be visited).
+template<typename Object, size_t ShardNum = ASCS_OBJECT_SHARD_NUM>
+class sharded_object_map
+{
+public:
+	typedef std::shared_ptr<Object> object_type;
+	typedef const object_type object_ctype;
+	typedef std::unordered_map<uint_fast64_t, object_type> container_type;
+	static_assert(ShardNum > 0, "ShardNum must be bigger than zero.");
+
+	sharded_object_map() : num(0) {}
+
+	bool add(object_ctype& object_ptr, size_t max_size)
+	{
+		//reserve a place first, so concurrent adders on different shards cannot exceed max_size
+		if (num.fetch_add(1, std::memory_order_relaxed) >= max_size)
+		{
+			num.fetch_sub(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		auto& s = get_shard(object_ptr->id());
+		std::unique_lock<ASCS_SHARED_MUTEX_TYPE> lock(s.mutex);
+		if (s.can.emplace(object_ptr->id(), object_ptr).second)
+			return true;
+		lock.unlock();
+
+		num.fetch_sub(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	object_type del(uint_fast64_t id)
+	{
+		auto object_ptr = object_type();
+
+		auto& s = get_shard(id);
+		std::unique_lock<ASCS_SHARED_MUTEX_TYPE> lock(s.mutex);
+		auto iter = s.can.find(id);
+		if (iter != std::end(s.can))
+		{
+			object_ptr = std::move(iter->second);
+			s.can.erase(iter);
+		}
+		lock.unlock();
+
+		if (object_ptr)
+			num.fetch_sub(1, std::memory_order_relaxed);
+
+		return object_ptr;
+	}
+
+	bool change_id(object_ctype& object_ptr, uint_fast64_t id)
+	{
+		auto& old_s = get_shard(object_ptr->id());
+		auto& new_s = get_shard(id);
+		if (&old_s == &new_s)
+		{
+			std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(new_s.mutex);
+			if (!new_s.can.emplace(id, object_ptr).second)
+				return false;
+
+			//the old id may not in the storage (for example, the object hasn't been added yet), then we got one more object
+			if (0 == new_s.can.erase(object_ptr->id()))
+				num.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		std::unique_lock<ASCS_SHARED_MUTEX_TYPE> lock1(old_s.mutex, std::defer_lock), lock2(new_s.mutex, std::defer_lock);
+		std::lock(lock1, lock2);
+		if (!new_s.can.emplace(id, object_ptr).second)
+			return false;
+
+		//the old id may not in the storage (for example, the object hasn't been added yet), then we got one more object
+		if (0 == old_s.can.erase(object_ptr->id()))
+			num.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	size_t size() {return num.load(std::memory_order_relaxed);}
+
+	bool exist(uint_fast64_t id)
+	{
+		auto& s = get_shard(id);
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(s.mutex);
+		return s.can.count(id) > 0;
+	}
+
+	object_type find(uint_fast64_t id)
+	{
+		auto& s = get_shard(id);
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(s.mutex);
+		auto iter = s.can.find(id);
+		return iter != std::end(s.can) ? iter->second : object_type();
+	}
+
+	//this method has linear complexity, please note.
+	object_type at(size_t index)
+	{
+		for (auto& s : shards)
+		{
+			ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(s.mutex);
+			if (index < s.can.size())
+				return std::next(std::begin(s.can), index)->second;
+			index -= s.can.size();
+		}
+
+		return object_type();
+	}
+
+	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred)
+	{
+		for (auto& s : shards)
+			{ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(s.mutex); for (auto& item : s.can) __pred(item.second);}
+	}
+
+	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred)
+	{
+		for (auto& s : shards)
+		{
+			ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(s.mutex);
+			for (auto iter = std::begin(s.can); iter != std::end(s.can); ++iter)
+				if (__pred(iter->second))
+					return;
+		}
+	}
+
+	template<typename _Predicate> void remove_if(const _Predicate& __pred, std::list<object_type>& objects)
+	{
+		for (auto& s : shards)
+		{
+			size_t removed = 0;
+
+			std::unique_lock<ASCS_SHARED_MUTEX_TYPE> lock(s.mutex);
+			for (auto iter = std::begin(s.can); iter != std::end(s.can);)
+				if (__pred(iter->second))
+				{
+					try {objects.emplace_back(std::move(iter->second));} catch (const std::exception& e) {unified_out::error_out("cannot hold more objects (%s)", e.what());}
+					iter = s.can.erase(iter);
+					++removed;
+				}
+				else
+					++iter;
+			lock.unlock();
+
+			if (removed > 0)
+				num.fetch_sub(removed, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	struct shard
+	{
+		container_type can;
+		ASCS_SHARED_MUTEX_TYPE mutex;
+		char padding[64]; //avoid false sharing between adjacent shards' locks
+	};
+
+	shard& get_shard(uint_fast64_t id) {return shards[std::hash<uint_fast64_t>()(id) % ShardNum];}
+
+private:
+	shard shards[ShardNum];
+	std::atomic_size_t num;
+};
+
+//a slot map, living objects (and their ids) are stored contiguously in a vector (so traversing is cache friendly and at is O(1)), and an open addressing
+//table (linear probing) maps ids to their positions in the vector, the slot of an id is derived from the id itself (fibonacci hashing,
+//sequential ids must be scattered, otherwise they form a huge cluster which makes deletion linear), and the whole id is kept in the slot
+//as the generation check.
+//find, exist, at, add and del are O(1) (del swaps the last object into the deleted one's position, so the order of objects changes).
+//the table keeps its load factor no larger than 0.5, and it never shrinks.
+template<typename Object>
+class slot_object_map
+{
+public:
+	typedef std::shared_ptr<Object> object_type;
+	typedef const object_type object_ctype;
+	typedef std::vector<object_type> container_type;
+
+	slot_object_map() : slots(16), shift(64 - 4) {}
+
+	//to reserve the vector and the table, not thread safe, so must be called before service_pump startup.
+	void reserve(size_t size)
+	{
+		objects.reserve(size);
+		ids.reserve(size);
+		auto capacity = slots.size();
+		while (capacity < 2 * size)
+			capacity <<= 1;
+		if (capacity > slots.size())
+			rehash(capacity);
+	}
+
+	bool add(object_ctype& object_ptr, size_t max_size)
+	{
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		if (objects.size() >= max_size || slots.size() != find_slot(object_ptr->id()))
+			return false;
+
+		if (2 * (objects.size() + 1) > slots.size())
+			rehash(2 * slots.size());
+
+		push_back(object_ptr, object_ptr->id());
+		return true;
+	}
+
+	object_type del(uint_fast64_t id)
+	{
+		auto object_ptr = object_type();
+
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		auto i = find_slot(id);
+		if (i < slots.size())
+		{
+			auto index = slots[i].index;
+			erase_slot(i);
+
+			object_ptr = std::move(objects[index]);
+			erase_object(index);
+		}
+
+		return object_ptr;
+	}
+
+	bool change_id(object_ctype& object_ptr, uint_fast64_t id)
+	{
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		if (slots.size() != find_slot(id))
+			return false;
+
+		auto i = find_slot(object_ptr->id());
+		if (i < slots.size())
+		{
+			auto index = slots[i].index;
+			erase_slot(i);
+			insert_slot(id, index);
+			ids[index] = id;
+		}
+		else //object_ptr hasn't been added yet, add it with the new id
+		{
+			if (2 * (objects.size() + 1) > slots.size())
+				rehash(2 * slots.size());
+
+			push_back(object_ptr, id);
+		}
+
+		return true;
+	}
+
+	size_t size()
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		return objects.size();
+	}
+
+	bool exist(uint_fast64_t id)
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		return find_slot(id) < slots.size();
+	}
+
+	object_type find(uint_fast64_t id)
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		auto i = find_slot(id);
+		return i < slots.size() ? objects[slots[i].index] : object_type();
+	}
+
+	object_type at(size_t index)
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		assert(index < objects.size());
+		return index < objects.size() ? objects[index] : object_type();
+	}
+
+	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred)
+		{ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex); for (auto& item : objects) __pred(item);}
+
+	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred)
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		for (auto iter = std::begin(objects); iter != std::end(objects); ++iter)
+			if (__pred(*iter))
+				break;
+	}
+
+	template<typename _Predicate> void remove_if(const _Predicate& __pred, std::list<object_type>& objects_)
+	{
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		for (size_t index = 0; index < objects.size();)
+			if (__pred(objects[index]))
+			{
+				erase_slot(find_slot(ids[index]));
+				try {objects_.emplace_back(std::move(objects[index]));} catch (const std::exception& e) {unified_out::error_out("cannot hold more objects (%s)", e.what());}
+				erase_object(index); //the last object been moved to index, so don't increase index
+			}
+			else
+				++index;
+	}
+
+private:
+	struct slot
+	{
+		uint_fast64_t id;
+		size_t index; //the position in objects, -1 means empty slot
+
+		slot() : id(0), index(-1) {}
+		bool empty() const {return (size_t) -1 == index;}
+	};
+
+	size_t mask() const {return slots.size() - 1;}
+	size_t home(uint_fast64_t id) const {return (size_t) ((uint64_t) (id * 11400714819323198485ULL) >> shift);}
+
+	//return slots.size() if not found
+	size_t find_slot(uint_fast64_t id) const
+	{
+		for (auto i = home(id); !slots[i].empty(); i = (i + 1) & mask())
+			if (slots[i].id == id)
+				return i;
+
+		return slots.size();
+	}
+
+	void insert_slot(uint_fast64_t id, size_t index)
+	{
+		auto i = home(id);
+		while (!slots[i].empty())
+			i = (i + 1) & mask();
+
+		slots[i].id = id;
+		slots[i].index = index;
+	}
+
+	//backward shift deletion, no tombstone needed
+	void erase_slot(size_t i)
+	{
+		assert(i < slots.size());
+		for (auto j = (i + 1) & mask(); !slots[j].empty(); j = (j + 1) & mask())
+		{
+			auto h = home(slots[j].id);
+			//move slot j to i if its home is not in the cyclic range (i, j]
+			if (i < j ? h <= i || h > j : h <= i && h > j)
+			{
+				slots[i] = slots[j];
+				i = j;
+			}
+		}
+
+		slots[i] = slot();
+	}
+
+	void push_back(object_ctype& object_ptr, uint_fast64_t id)
+	{
+		objects.emplace_back(object_ptr);
+		try {ids.push_back(id);} catch (const std::exception&) {objects.pop_back(); throw;}
+		insert_slot(id, objects.size() - 1);
+	}
+
+	//move the last object to index and update its slot, index must have been removed from slots.
+	void erase_object(size_t index)
+	{
+		auto last = objects.size() - 1;
+		if (index != last)
+		{
+			auto i = find_slot(ids[last]);
+			assert(i < slots.size());
+			slots[i].index = index;
+			objects[index] = std::move(objects[last]);
+			ids[index] = ids[last];
+		}
+		objects.pop_back();
+		ids.pop_back();
+	}
+
+	void rehash(size_t capacity)
+	{
+		std::vector<slot> old_slots(capacity);
+		old_slots.swap(slots);
+		for (shift = 64; capacity > 1; capacity >>= 1)
+			--shift;
+		for (auto& item : old_slots)
+			if (!item.empty())
+				insert_slot(item.id, item.index);
+	}
+
+private:
+	container_type objects;
+	std::vector<uint_fast64_t> ids; //ids of objects (in the same order), objects' ids can be changed before they are removed from slots
+	std::vector<slot> slots;
+	unsigned shift; //64 - log2(slots.size())
+	ASCS_SHARED_MUTEX_TYPE object_can_mutex;
+};
+
+//an unordered_map (guarded by one ASCS_SHARED_MUTEX_TYPE) plus an immutable snapshot (a vector) of all objects, the snapshot is rebuilt
+//lazily by the first traversal after modifications (under the shared lock, it only copies pointers), and published via std::atomic_store,
+//then traversals (do_something_to_all/one, at) grab it in O(1) and walk through it without any lock, so broadcasting, get_statistic and
+//clear_obsoleted_object will not block adding and deleting objects (connection churn) during their fan-out.
+//old snapshots are reclaimed by std::shared_ptr after the last traversal which holds it finished.
+//a traversal only sees the objects at the time the snapshot was built, objects deleted since then may still be visited (they're still alive
+//because the snapshot holds them), objects added since then will not be visited.
+template<typename Object>
+class snapshot_object_map
+{
+public:
+	typedef std::shared_ptr<Object> object_type;
+	typedef const object_type object_ctype;
+	typedef std::unordered_map<uint_fast64_t, object_type> container_type;
+	typedef std::shared_ptr<const std::vector<object_type>> snapshot_type;
+
+	//to configure unordered_map (for example, set factor or reserved size), not thread safe, so must be called before service_pump startup.
+	container_type& container() {return object_can;}
+
+	bool add(object_ctype& object_ptr, size_t max_size)
+	{
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		if (object_can.size() >= max_size || !object_can.emplace(object_ptr->id(), object_ptr).second)
+			return false;
+
+		std::atomic_store(&snapshot_, snapshot_type());
+		return true;
+	}
+
+	object_type del(uint_fast64_t id)
+	{
+		auto object_ptr = object_type();
+
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		auto iter = object_can.find(id);
+		if (iter != std::end(object_can))
+		{
+			object_ptr = std::move(iter->second);
+			object_can.erase(iter);
+			std::atomic_store(&snapshot_, snapshot_type());
+		}
+
+		return object_ptr;
+	}
+
+	bool change_id(object_ctype& object_ptr, uint_fast64_t id)
+	{
+		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		if (!object_can.emplace(id, object_ptr).second)
+			return false;
+
+		if (0 == object_can.erase(object_ptr->id())) //object_ptr hasn't been added yet, it's a new object
+			std::atomic_store(&snapshot_, snapshot_type());
+		return true;
+	}
+
+	size_t size()
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		return object_can.size();
+	}
+
+	bool exist(uint_fast64_t id)
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		return object_can.count(id) > 0;
+	}
+
+	object_type find(uint_fast64_t id)
+	{
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		auto iter = object_can.find(id);
+		return iter != std::end(object_can) ? iter->second : object_type();
+	}
+
+	//O(1) if the snapshot is up to date, index is for the snapshot, so it may not match size() exactly.
+	object_type at(size_t index) {auto s = snapshot(); return index < s->size() ? (*s)[index] : object_type();}
+
+	//the current snapshot, never be null.
+	snapshot_type snapshot()
+	{
+		auto s = std::atomic_load(&snapshot_);
+		if (s)
+			return s;
+
+		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+		s = std::atomic_load(&snapshot_); //maybe another traversal has rebuilt it
+		if (!s)
+		{
+			auto objects = std::make_shared<std::vector<object_type>>();
+			objects->reserve(object_can.size());
+			for (auto& item : object_can)
+				objects->emplace_back(item.second);
+
+			s = objects;
+			std::atomic_store(&snapshot_, s); //must be published under the lock, otherwise, a stale snapshot can overwrite a newer modification
+		}
+
+		return s;
+	}
+
+	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred) {auto s = snapshot(); for (auto& item : *s) __pred(item);}
+
+	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred)
+	{
+		auto s = snapshot();
+		for (auto iter = std::begin(*s); iter != std::end(*s); ++iter)
+			if (__pred(*iter))
+				break;
+	}
+
+	//__pred is evaluated on the snapshot without lock, then candidates are deleted one by one (only if they are still in the storage).
+	template<typename _Predicate> void remove_if(const _Predicate& __pred, std::list<object_type>& objects)
+	{
+		auto s = snapshot();
+		for (auto& item : *s)
+			if (__pred(item))
+			{
+				std::unique_lock<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
+				auto iter = object_can.find(item->id());
+				if (iter == std::end(object_can) || iter->second != item)
+					continue;
+
+				object_can.erase(iter);
+				std::atomic_store(&snapshot_, snapshot_type());
+				lock.unlock();
+
+				try {objects.emplace_back(item);} catch (const std::exception& e) {unified_out::error_out("cannot hold more objects (%s)", e.what());}
+			}
+	}
+
+private:
+	container_type object_can;
+	snapshot_type snapshot_; //null means outdated
+	ASCS_SHARED_MUTEX_TYPE object_can_mutex;
+};
+
+} //namespace
+
+#endif /* _ASCS_OBJECT_CONTAINER_H_ */
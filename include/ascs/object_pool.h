@@ -14,8 +14,10 @@
 #ifndef _ASCS_OBJECT_POOL_H_
 #define _ASCS_OBJECT_POOL_H_
 
-#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
 
+#include "object_container.h"
 #include "executor.h"
 #include "timer.h"
 #include "service_pump.h"
@@ -23,17 +25,18 @@
 namespace ascs
 {
 
-template<typename Object>
-class object_pool : public service_pump::i_service, protected timer<executor>
+template<typename Object, typename Container = object_map<Object>>
+class object_pool : public service_pump::i_service, protected timer<executor>, public i_object_pool, public i_inbox<typename Object::out_msg_type>
 {
 public:
 	typedef typename Object::in_msg_type in_msg_type;
 	typedef typename Object::in_msg_ctype in_msg_ctype;
 	typedef typename Object::out_msg_type out_msg_type;
 	typedef typename Object::out_msg_ctype out_msg_ctype;
+	typedef typename Object::packer_type packer_type;
 	typedef std::shared_ptr<Object> object_type;
 	typedef const object_type object_ctype;
-	typedef std::unordered_map<uint_fast64_t, object_type> container_type;
+	typedef Container container_type;
 
 	static const tid TIMER_BEGIN = timer<executor>::TIMER_END;
 	static const tid TIMER_FREE_SOCKET = TIMER_BEGIN;
@@ -44,10 +47,14 @@ public:
 	void set_start_object_id(uint_fast64_t id) {cur_id.store(id - 1, std::memory_order_relaxed);} //call this right after object_pool been constructed
 
 protected:
-	object_pool(service_pump& service_pump_) : i_service(service_pump_), timer<executor>(service_pump_), cur_id(ASCS_START_OBJECT_ID - 1), max_size_(ASCS_MAX_OBJECT_NUM) {}
+	object_pool(service_pump& service_pump_) : i_service(service_pump_), timer<executor>(service_pump_), cur_id(ASCS_START_OBJECT_ID - 1), max_size_(ASCS_MAX_OBJECT_NUM), chunk_size_(ASCS_PARALLEL_CHUNK_SIZE), dis_executor(nullptr), mem_gov(nullptr),
+		inbox_consumer_num_(0), inbox_buf_size_(ASCS_MAX_INBOX_BUF), inbox_size_in_byte_(0), inbox_stopped(false) {}
+	//inbox consumers call virtual function on_inbox_batch, so they must have been stopped (by service_pump, see finalize) before destruction.
+	virtual ~object_pool() {assert(inbox_consumers.empty());}
 
 	void start()
 	{
+		start_inbox();
 #if !defined(ASCS_REUSE_OBJECT) && !defined(ASCS_RESTORE_OBJECT)
 		set_timer(TIMER_FREE_SOCKET, 1000 * ASCS_FREE_OBJECT_INTERVAL, [this](tid id)->bool {this->free_object(); return true;});
 #endif
@@ -57,6 +64,9 @@ protected:
 	}
 
 	void stop() {stop_all_timer();}
+	//called by service_pump after all service threads and the dispatch pool quit, so no more msgs will be pushed into the inbox,
+	// consumers drain the inbox and then quit.
+	virtual void finalize() {stop_inbox();}
 
 	bool add_object(object_ctype& object_ptr)
 	{
@@ -64,46 +74,23 @@ protected:
 			return false;
 		assert(!object_ptr->is_equal_to(-1));
 
-		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
-		return object_can.size() < max_size_ ? object_can.emplace(object_ptr->id(), object_ptr).second : false;
+		return object_can.add(object_ptr, max_size_);
 	}
 
-	//only add object_ptr to invalid_object_can when it's in object_can, this can avoid duplicated items in invalid_object_can, because invalid_object_can is a list,
-	//there's no way to check the existence of an item in a list efficiently.
+	//only add object_ptr to invalid objects when it's in object_can, this can avoid duplicated items in invalid objects.
 	bool del_object(object_ctype& object_ptr)
 	{
 		assert(object_ptr);
-
-		std::unique_lock<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
-		auto exist = object_can.erase(object_ptr->id()) > 0;
-		lock.unlock();
-
-		if (exist)
-		{
-			std::lock_guard<std::mutex> lock(invalid_object_can_mutex);
-			try {invalid_object_can.emplace_back(object_ptr);} catch (const std::exception& e) {unified_out::error_out("cannot hold more objects (%s)", e.what());}
-		}
-
-		return exist;
+		return del_object(object_ptr->id());
 	}
 
 	bool del_object(uint_fast64_t id)
 	{
-		auto object_ptr = object_type();
-
-		std::unique_lock<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
-		auto iter = object_can.find(id);
-		if (iter != std::end(object_can))
-		{
-			object_ptr = iter->second;
-			object_can.erase(iter);
-		}
-		lock.unlock();
-
+		auto object_ptr = object_can.del(id);
 		if (object_ptr)
 		{
 			std::lock_guard<std::mutex> lock(invalid_object_can_mutex);
-			try {invalid_object_can.emplace_back(object_ptr);} catch (const std::exception& e) {unified_out::error_out("cannot hold more objects (%s)", e.what());}
+			add_invalid_object(object_ptr);
 		}
 
 		return !!object_ptr;
@@ -117,6 +104,10 @@ protected:
 		if (object_ptr)
 		{
 			object_ptr->id(1 + cur_id.fetch_add(1, std::memory_order_relaxed));
+			object_ptr->pool(this);
+			object_ptr->dispatch_executor(dis_executor);
+			object_ptr->inbox(inbox_consumer_num_ > 0 ? this : nullptr);
+			object_ptr->mem_governor(mem_gov);
 			on_create(object_ptr);
 		}
 		else
@@ -130,21 +121,19 @@ protected:
 		if (object_ptr->is_equal_to(id))
 			return true;
 
-		std::lock_guard<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
-		if (!object_can.emplace(id, object_ptr).second)
+		if (!object_can.change_id(object_ptr, id))
 			return false;
 
-		object_can.erase(object_ptr->id());
 		object_ptr->id(id);
 		return true;
 	}
 
 	//change object_ptr's id to id, and reinsert it into object_can.
-	//there MUST exist an object in invalid_object_can whose id is equal to id to guarantee the id has been abandoned
+	//there MUST exist an invalid object whose id is equal to id to guarantee the id has been abandoned
 	// (checking existence of such object in object_can is NOT enough, because there are some sockets used by async
-	// acceptance, they don't exist in object_can nor invalid_object_can), further more, the invalid object MUST be
+	// acceptance, they don't exist in object_can nor invalid objects), further more, the invalid object MUST be
 	// obsoleted and has no additional reference.
-	//return the invalid object (null means failure), please note that the invalid object has been removed from invalid_object_can.
+	//return the invalid object (null means failure), please note that the invalid object has been removed from invalid objects.
 	object_type change_object_id(object_ctype& object_ptr, uint_fast64_t id)
 	{
 		assert(object_ptr && !object_ptr->is_equal_to(-1));
@@ -153,7 +142,7 @@ protected:
 		if (old_object_ptr && !init_object_id(object_ptr, id))
 		{
 			std::lock_guard<std::mutex> lock(invalid_object_can_mutex);
-			invalid_object_can.push_back(old_object_ptr);
+			add_invalid_object(old_object_ptr);
 			old_object_ptr.reset();
 		}
 
@@ -194,87 +183,61 @@ return object_ptr;
 #endif
 
 public:
-	//to configure unordered_set(for example, set factor or reserved size), not thread safe, so must be called before service_pump startup.
+	//to configure the storage (for example, object_map::container() returns the unordered_map, then you can set factor or reserved size),
+	//not thread safe, so must be called before service_pump startup.
 	container_type& container() {return object_can;}
 
 	size_t max_size() const {return max_size_;}
 	void max_size(size_t _max_size) {max_size_ = _max_size;}
 
-	size_t size()
-	{
-		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
-		return object_can.size();
-	}
-
-	bool exist(uint_fast64_t id)
-	{
-		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
-		return object_can.count(id) > 0;
-	}
-
-	object_type find(uint_fast64_t id)
-	{
-		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
-		auto iter = object_can.find(id);
-		return iter != std::end(object_can) ? iter->second : object_type();
-	}
-
-	//this method has linear complexity, please note.
-	object_type at(size_t index)
-	{
-		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
-		assert(index < object_can.size());
-		return index < object_can.size() ? std::next(std::begin(object_can), index)->second : object_type();
-	}
+	size_t size() {return object_can.size();}
+	bool exist(uint_fast64_t id) {return object_can.exist(id);}
+	object_type find(uint_fast64_t id) {return object_can.find(id);}
+	//the complexity depends on the storage, linear with object_map and sharded_object_map, constant with slot_object_map and snapshot_object_map.
+	object_type at(size_t index) {return object_can.at(index);}
 
 	size_t invalid_object_size()
 	{
 		std::lock_guard<std::mutex> lock(invalid_object_can_mutex);
-		return invalid_object_can.size();
+		return invalid_object_can.size() + ready_object_can.size();
 	}
 
-	//this method has linear complexity, please note.
 	object_type invalid_object_find(uint_fast64_t id)
 	{
 		std::lock_guard<std::mutex> lock(invalid_object_can_mutex);
-		auto iter = std::find_if(std::begin(invalid_object_can), std::end(invalid_object_can), [&id](object_ctype& item) {return item->is_equal_to(id);});
-		return iter == std::end(invalid_object_can) ? object_type() : *iter;
+		auto iter = invalid_object_index.find(id);
+		return iter == std::end(invalid_object_index) ? object_type() : *iter->second.first;
 	}
 
 	//this method has linear complexity, please note.
 	object_type invalid_object_at(size_t index)
 	{
 		std::lock_guard<std::mutex> lock(invalid_object_can_mutex);
-		assert(index < invalid_object_can.size());
-		return index < invalid_object_can.size() ? *std::next(std::begin(invalid_object_can), index) : object_type();
+		assert(index < invalid_object_can.size() + ready_object_can.size());
+		if (index < invalid_object_can.size())
+			return *std::next(std::begin(invalid_object_can), index);
+
+		index -= invalid_object_can.size();
+		return index < ready_object_can.size() ? *std::next(std::begin(ready_object_can), index) : object_type();
 	}
 
-	//this method has linear complexity, please note.
 	object_type invalid_object_pop(uint_fast64_t id)
 	{
 		std::lock_guard<std::mutex> lock(invalid_object_can_mutex);
-		auto iter = std::find_if(std::begin(invalid_object_can), std::end(invalid_object_can), [&id](object_ctype& item) {return item->is_equal_to(id);});
-		if (iter != std::end(invalid_object_can) && (*iter).unique() && (*iter)->obsoleted())
-		{
-			auto object_ptr(std::move(*iter));
-			invalid_object_can.erase(iter);
-			return object_ptr;
-		}
+		auto range = invalid_object_index.equal_range(id);
+		for (auto iter = range.first; iter != range.second; ++iter)
+			if ((*iter->second.first).unique() && (*iter->second.first)->obsoleted())
+				return remove_invalid_object(iter);
+
 		return object_type();
 	}
 
-	//this method has linear complexity, please note.
+	//pop an object from the ready list, objects in it have finished closing, so the first one almost always can be reused (has no additional reference),
+	//objects which are still closing will never be checked, they will be moved to the ready list after they finished closing (see on_obsoleted).
 	object_type invalid_object_pop()
 	{
 		std::lock_guard<std::mutex> lock(invalid_object_can_mutex);
-		for (auto iter = std::begin(invalid_object_can); iter != std::end(invalid_object_can); ++iter)
-			if ((*iter).unique() && (*iter)->obsoleted())
-			{
-				auto object_ptr(std::move(*iter));
-				invalid_object_can.erase(iter);
-				return object_ptr;
-			}
-		return object_type();
+		return pop_ready_object();
 	}
 
 	//Kick out obsoleted objects
@@ -284,18 +247,8 @@ public:
 	//object_pool will automatically invoke this function if ASCS_CLEAR_OBJECT_INTERVAL been defined
 	size_t clear_obsoleted_object()
 	{
-		decltype(invalid_object_can) objects;
-
-		std::unique_lock<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
-		for (auto iter = std::begin(object_can); iter != std::end(object_can);)
-			if (iter->second->obsoleted())
-			{
-				try {objects.emplace_back(std::move(iter->second));} catch (const std::exception& e) {unified_out::error_out("cannot hold more objects (%s)", e.what());}
-				iter = object_can.erase(iter);
-			}
-			else
-				++iter;
-		lock.unlock();
+		std::list<object_type> objects;
+		object_can.remove_if([](object_ctype& item) {return item->obsoleted();}, objects);
 
 		auto size = objects.size();
 		if (0 != size)
@@ -303,7 +256,8 @@ public:
 			unified_out::warning_out(ASCS_SF " object(s) been kicked out!", size);
 
 			std::lock_guard<std::mutex> lock(invalid_object_can_mutex);
-			invalid_object_can.splice(std::end(invalid_object_can), objects);
+			for (auto& item : objects)
+				add_invalid_object(item);
 		}
 
 		return size;
@@ -311,20 +265,21 @@ public:
 
 	//free a specific number of objects
 	//if you used object pool(define ASCS_REUSE_OBJECT or ASCS_RESTORE_OBJECT), you can manually call this function to free some objects
-	// after the object pool(invalid_object_size()) gets big enough for memory saving (because the objects in invalid_object_can
+	// after the object pool(invalid_object_size()) gets big enough for memory saving (because the invalid objects
 	// are waiting for reusing and will never be freed).
 	//if you don't used object pool, object_pool will invoke this function automatically and periodically, so you don't need to invoke this function exactly
+	//only objects in the ready list will be freed (objects which are still closing will not be checked, see invalid_object_pop for more details).
 	//return affected object number.
 	size_t free_object(size_t num = -1)
 	{
 		size_t num_affected = 0;
 
 		std::unique_lock<std::mutex> lock(invalid_object_can_mutex);
-		for (auto iter = std::begin(invalid_object_can); num > 0 && iter != std::end(invalid_object_can);)
+		for (auto iter = std::begin(ready_object_can); num > 0 && iter != std::end(ready_object_can);)
 			//checking unique() is essential, consider following situation:
 			//{
 			//	auto socket_ptr = server.find(id);
-			//	//between these two sentences, the socket_ptr can be shut down and moved from object_can to invalid_object_can, then removed from invalid_object_can
+			//	//between these two sentences, the socket_ptr can be shut down and moved from object_can to invalid objects, then removed from invalid objects
 			//	//in this function without unique() checking.
 			//	socket_ptr->set_timer(...);
 			//}
@@ -333,7 +288,8 @@ public:
 			{
 				--num;
 				++num_affected;
-				iter = invalid_object_can.erase(iter);
+				erase_index(iter);
+				iter = ready_object_can.erase(iter);
 			}
 			else
 				++iter;
@@ -349,33 +305,312 @@ public:
 	void list_all_status() {do_something_to_all([](object_ctype& item) {item->show_status();});}
 	void list_all_object() {do_something_to_all([](object_ctype& item) {item->show_info();});}
 
-	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred)
-		{ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex); for (auto& item : object_can) __pred(item.second);}
+	template<typename _Predicate> void do_something_to_all(const _Predicate& __pred) {object_can.do_something_to_all(__pred);}
+	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred) {object_can.do_something_to_one(__pred);}
+
+	//statistic of one chunk of parallel_do_something_to_all.
+	struct chunk_statistic
+	{
+		size_t object_num; //objects in this chunk
+		size_t affected_num; //objects that __pred returned true
+		std::chrono::system_clock::duration wait_time; //from parallel_do_something_to_all to this chunk been started in a service thread
+		std::chrono::system_clock::duration run_time; //from this chunk been started to this chunk been finished
+
+		chunk_statistic() : object_num(0), affected_num(0), wait_time(0), run_time(0) {}
+	};
+	typedef std::function<void(const std::vector<chunk_statistic>&)> parallel_handler;
+
+	//objects per chunk of parallel_do_something_to_all, not thread safe, so must be called before service_pump startup.
+	size_t chunk_size() const {return chunk_size_;}
+	void chunk_size(size_t _chunk_size) {chunk_size_ = std::max(_chunk_size, (size_t) 1);}
+
+	//all objects created (or reused) from now on will dispatch msgs in executor, see ascs::socket::dispatch_executor for more details,
+	// normally, call this before service_pump startup with service_pump::get_dispatch_pool(), null means service threads.
+	void dispatch_executor(i_dispatch_executor* executor) {dis_executor = executor;}
+	i_dispatch_executor* dispatch_executor() const {return dis_executor;}
+
+	//all objects created from now on will charge their buffers against governor, see ascs::socket::mem_governor for more details,
+	// normally, call this before service_pump startup with service_pump::get_memory_governor(), null means no global limitation.
+	void mem_governor(memory_governor* governor) {mem_gov = governor;}
+	memory_governor* mem_governor() const {return mem_gov;}
+
+	//fan-in inbox, sockets (created or reused from now on) push their msgs (with their ids) into this object_pool's inbox rather than
+	// dispatching them one by one, inbox_consumer_num() threads take all msgs out of the inbox at a time and call on_inbox_batch with them.
+	//msgs of a socket keep their order in the inbox, but if there're more than one consumer, successive batches can be handled concurrently.
+	//consumers start with this object_pool, and quit after service_pump stopped all service threads (see finalize), so stop service_pump
+	// (service_pump::stop_service) before destroying this object_pool.
+	//not thread safe, so must be called before service_pump startup, 0 (the default) disables the inbox.
+	void inbox_consumer_num(int num) {inbox_consumer_num_ = std::max(num, 0);}
+	int inbox_consumer_num() const {return inbox_consumer_num_;}
+	//byte budget of the inbox, see macro ASCS_MAX_INBOX_BUF for more details.
+	void inbox_buf_size(size_t size) {if (size > 0) inbox_buf_size_ = size;}
+	size_t inbox_buf_size() const {return inbox_buf_size_;}
+	size_t inbox_size_in_byte() const {return inbox_size_in_byte_;}
+
+	//implement i_inbox's pure virtual functions
+	virtual void push(uint_fast64_t id, std::list<out_msg_type>& msgs, size_t size_in_byte)
+	{
+		std::lock_guard<std::mutex> lock(inbox_mutex);
+		inbox_can.emplace_back(id);
+		inbox_can.back().msgs.splice(std::end(inbox_can.back().msgs), msgs);
+		inbox_size_in_byte_ += size_in_byte;
+		inbox_cv.notify_one();
+	}
+	virtual bool is_available(uint_fast64_t id)
+	{
+		if (inbox_size_in_byte_ < inbox_buf_size_)
+			return true;
+
+		std::lock_guard<std::mutex> lock(inbox_mutex);
+		if (inbox_size_in_byte_ < inbox_buf_size_) //a consumer just drained the inbox
+			return true;
+
+		throttled_ids.insert(id);
+		return false;
+	}
+
+	//take a copy of all objects, partition them into chunks (chunk_size() objects each) and post each chunk to service threads, so chunks
+	//will be handled concurrently if service_pump has more than one thread. __pred (bool(object_ctype&)) will be invoked in service threads,
+	//so it must be thread safe and mustn't block, its return value will be counted in chunk_statistic::affected_num.
+	//handler will be invoked after all chunks been finished, in the service thread which finished the last chunk, or in the calling thread
+	//directly if there's no object at all. if service_pump is not running, chunks (and handler) will not be invoked until it starts.
+	template<typename _Predicate> void parallel_do_something_to_all(const _Predicate& __pred, const parallel_handler& handler)
+	{
+		struct parallel_context
+		{
+			parallel_context(const _Predicate& pred_, const parallel_handler& handler_) : pred(pred_), handler(handler_) {}
+
+			_Predicate pred;
+			parallel_handler handler;
+			std::vector<object_type> objects;
+			std::vector<chunk_statistic> stats;
+			std::atomic_size_t left_num;
+			std::chrono::system_clock::time_point begin_time;
+		};
+
+		auto context = std::make_shared<parallel_context>(__pred, handler);
+		context->objects.reserve(size());
+		do_something_to_all([&](object_ctype& item) {context->objects.emplace_back(item);});
+
+		auto chunk_size = chunk_size_;
+		auto chunk_num = (context->objects.size() + chunk_size - 1) / chunk_size;
+		if (0 == chunk_num)
+		{
+			if (handler)
+				handler(context->stats);
+			return;
+		}
+
+		context->stats.resize(chunk_num);
+		context->left_num = chunk_num;
+		context->begin_time = std::chrono::system_clock::now();
+		for (size_t i = 0; i < chunk_num; ++i)
+			post([context, i, chunk_size]() {
+				auto& stat = context->stats[i];
+				auto begin_time = std::chrono::system_clock::now();
+				stat.wait_time = begin_time - context->begin_time;
+
+				auto end = std::min((i + 1) * chunk_size, context->objects.size());
+				stat.object_num = end - i * chunk_size;
+				for (auto j = i * chunk_size; j < end; ++j)
+					if (context->pred(context->objects[j]))
+						++stat.affected_num;
+				stat.run_time = std::chrono::system_clock::now() - begin_time;
+
+				if (1 == context->left_num.fetch_sub(1) && context->handler) //the last chunk, all stats are visible now
+					context->handler(context->stats);
+			});
+	}
+
+protected:
+	struct inbox_batch
+	{
+		inbox_batch(uint_fast64_t id_) : id(id_) {}
+
+		uint_fast64_t id; //the socket's id
+		std::list<out_msg_type> msgs;
+	};
+	typedef std::list<inbox_batch> inbox_type;
+
+	//called by inbox consumers (see inbox_consumer_num) with all msgs they took from the inbox, in the order of pushing, batches can be
+	// moved away, and use find(id) to reply (for example).
+	virtual void on_inbox_batch(inbox_type& batches) {}
+
+	//called by sockets (created by this object_pool) after they finished closing (on every close path), move them from invalid_object_can to
+	// ready_object_can if they are invalid objects, otherwise, they will be put into ready_object_can directly when del_object (if they are not
+	// started and not closing at that time, see socket::is_closing).
+	virtual void on_obsoleted(uint_fast64_t id)
+	{
+		std::lock_guard<std::mutex> lock(invalid_object_can_mutex);
+		auto range = invalid_object_index.equal_range(id);
+		for (auto iter = range.first; iter != range.second; ++iter)
+			if (!iter->second.second)
+			{
+				ready_object_can.splice(std::end(ready_object_can), invalid_object_can, iter->second.first);
+				iter->second.second = true;
+			}
+	}
+
+private:
+	void start_inbox()
+	{
+		if (inbox_consumer_num_ <= 0 || !inbox_consumers.empty())
+			return;
+
+		inbox_stopped = false;
+		for (auto i = 0; i < inbox_consumer_num_; ++i)
+			inbox_consumers.emplace_back([this]() {this->consume_inbox();});
+	}
 
-	template<typename _Predicate> void do_something_to_one(const _Predicate& __pred)
+	//consumers quit after they drained the inbox.
+	void stop_inbox()
 	{
-		ASCS_SHARED_LOCK_TYPE<ASCS_SHARED_MUTEX_TYPE> lock(object_can_mutex);
-		for (auto iter = std::begin(object_can); iter != std::end(object_can); ++iter)
-			if (__pred(iter->second))
+		std::unique_lock<std::mutex> lock(inbox_mutex);
+		inbox_stopped = true;
+		inbox_cv.notify_all();
+		lock.unlock();
+
+		ascs::do_something_to_all(inbox_consumers, [](std::thread& t) {t.join();});
+		inbox_consumers.clear();
+	}
+
+	void consume_inbox()
+	{
+		while (true)
+		{
+			inbox_type batches;
+			std::unordered_set<uint_fast64_t> ids;
+
+			std::unique_lock<std::mutex> lock(inbox_mutex);
+			inbox_cv.wait(lock, [this]() {return this->inbox_stopped || !this->inbox_can.empty();});
+			if (inbox_can.empty())
 				break;
+
+			batches.swap(inbox_can);
+			ids.swap(throttled_ids);
+			inbox_size_in_byte_ = 0;
+			lock.unlock();
+
+			for (auto& id : ids) //the inbox is available now
+			{
+				auto object_ptr = find(id);
+				if (object_ptr)
+					object_ptr->resume_recv();
+			}
+
+#ifdef ASCS_NO_TRY_CATCH
+			on_inbox_batch(batches);
+#else
+			try {on_inbox_batch(batches);} catch (const std::exception& e) {unified_out::error_out("inbox consumer exception: %s.", e.what());}
+#endif
+		}
+	}
+
+	typedef std::list<object_type> object_list;
+	typedef std::unordered_multimap<uint_fast64_t, std::pair<typename object_list::iterator, bool>> object_index;
+
+	//following functions must be called with invalid_object_can_mutex locked
+	void add_invalid_object(object_ctype& object_ptr)
+	{
+		auto ready = !object_ptr->started() && !object_ptr->is_closing();
+		auto& can = ready ? ready_object_can : invalid_object_can;
+		try
+		{
+			can.emplace_back(object_ptr);
+			try {invalid_object_index.emplace(object_ptr->id(), std::make_pair(std::prev(std::end(can)), ready));}
+			catch (const std::exception&) {can.pop_back(); throw;}
+		}
+		catch (const std::exception& e) {unified_out::error_out("cannot hold more objects (%s)", e.what());}
+	}
+
+	object_type remove_invalid_object(typename object_index::iterator iter)
+	{
+		auto& can = iter->second.second ? ready_object_can : invalid_object_can;
+		auto object_ptr(std::move(*iter->second.first));
+		can.erase(iter->second.first);
+		invalid_object_index.erase(iter);
+
+		return object_ptr;
+	}
+
+	typename object_index::iterator find_index(typename object_list::iterator list_iter)
+	{
+		auto range = invalid_object_index.equal_range((*list_iter)->id());
+		auto iter = std::find_if(range.first, range.second, [&list_iter](const typename object_index::value_type& item) {return item.second.first == list_iter;});
+		assert(iter != range.second);
+		return iter != range.second ? iter : std::end(invalid_object_index);
+	}
+
+	void erase_index(typename object_list::iterator list_iter)
+	{
+		auto iter = find_index(list_iter);
+		if (iter != std::end(invalid_object_index))
+			invalid_object_index.erase(iter);
+	}
+
+	//only check a few objects at the front, objects which cannot be reused right now (still referenced, for example by pending asynchronous
+	// calls or users) are rotated to the back, so they will not be checked again and again.
+	object_type pop_ready_object()
+	{
+		for (size_t i = 0; i < ASCS_MAX_READY_OBJECT_CHECK && !ready_object_can.empty(); ++i)
+		{
+			auto iter = std::begin(ready_object_can);
+			if ((*iter).unique() && (*iter)->obsoleted())
+			{
+				erase_index(iter);
+				auto object_ptr(std::move(*iter));
+				ready_object_can.erase(iter);
+				return object_ptr;
+			}
+
+			ready_object_can.splice(std::end(ready_object_can), ready_object_can, iter); //iterators (in the index) are still valid
+		}
+
+		return object_type();
 	}
 
 private:
 	std::atomic_uint_fast64_t cur_id;
 
 	container_type object_can;
-	ASCS_SHARED_MUTEX_TYPE object_can_mutex;
 	size_t max_size_;
+	size_t chunk_size_;
+	i_dispatch_executor* dis_executor;
+	memory_governor* mem_gov;
+
+	int inbox_consumer_num_;
+	size_t inbox_buf_size_;
+	std::atomic_size_t inbox_size_in_byte_;
+	bool inbox_stopped;
+	inbox_type inbox_can;
+	std::unordered_set<uint_fast64_t> throttled_ids; //sockets which found the inbox full, they will be resumed by consumers
+	std::mutex inbox_mutex;
+	std::condition_variable inbox_cv;
+	std::list<std::thread> inbox_consumers;
 
 	//because all objects are dynamic created and stored in object_can, after receiving error occurred (you are recommended to delete the object from object_can,
 	//for example via i_server::del_socket), maybe some other asynchronous calls are still queued in asio::io_context, and will be dequeued in the future,
-	//we must guarantee these objects not be freed from the heap or reused, so we move these objects from object_can to invalid_object_can, and free them
+	//we must guarantee these objects not be freed from the heap or reused, so we move these objects from object_can to invalid objects, and free them
 	//from the heap or reuse them in the near future. if ASCS_CLEAR_OBJECT_INTERVAL been defined, clear_obsoleted_object() will be invoked automatically and
-	//periodically to move all invalid objects into invalid_object_can.
-	std::list<object_type> invalid_object_can;
+	//periodically to move all obsoleted objects in object_can into invalid objects.
+	//invalid objects which are still closing are in invalid_object_can, after they finished closing (see on_obsoleted), they will be moved to
+	//ready_object_can (the ready list), which is the only list object reusing and freeing walk through, invalid_object_index indexes both lists by id
+	//(the bool indicates whether the object is in ready_object_can or not), so restoring (change_object_id) doesn't need to walk through any list.
+	object_list invalid_object_can, ready_object_can;
+	object_index invalid_object_index;
 	std::mutex invalid_object_can_mutex;
 };
 
+//a convenient alias to use sharded_object_map with ASCS_OBJECT_SHARD_NUM shards, for example:
+//server_base<my_socket, sharded_object_pool<my_socket>> server(sp);
+template<typename Object> using sharded_object_pool = object_pool<Object, sharded_object_map<Object>>;
+//a convenient alias to use slot_object_map, for example:
+//server_base<my_socket, slot_object_pool<my_socket>> server(sp);
+template<typename Object> using slot_object_pool = object_pool<Object, slot_object_map<Object>>;
+//a convenient alias to use snapshot_object_map, for example:
+//server_base<my_socket, snapshot_object_pool<my_socket>> server(sp);
+template<typename Object> using snapshot_object_pool = object_pool<Object, snapshot_object_map<Object>>;
+
 } //namespace
 
 #endif /* _ASCS_OBJECT_POOL_H_ */
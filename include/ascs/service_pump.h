@@ -13,11 +13,163 @@
 #ifndef _ASCS_SERVICE_PUMP_H_
 #define _ASCS_SERVICE_PUMP_H_
 
-#include "base.h"
+#include "memory_governor.h"
 
 namespace ascs
 {
 
+//a thread pool which runs msg dispatching out of service threads, so slow msg handling will not steal time from reading, writing,
+// accepting and timers. each worker has its own io_context and thread, handlers are distributed to workers by key (the socket id),
+// so a socket is always dispatched by the same worker (actor style) and its msgs keep their order without strands.
+//service_pump owns one (see service_pump::dispatch_thread_num), you can also create your own and start/stop it by yourself.
+class dispatch_pool : public i_dispatch_executor
+{
+public:
+	struct worker_statistic
+	{
+		worker_statistic() : queue_depth(0), handled_num(0) {}
+
+		std::string to_string() const
+		{
+			std::ostringstream s;
+			s << "queue depth: " << queue_depth << std::endl << "handled number: " << handled_num
+#ifdef ASCS_FULL_STATISTIC
+				<< std::endl << "waiting duration: " << wait_time_sum << std::endl << "handling duration: " << handle_time_sum
+#endif
+			;return s.str();
+		}
+
+		size_t queue_depth; //handlers which are waiting in this worker
+		uint_fast64_t handled_num;
+		statistic::stat_duration wait_time_sum; //from posting to invoking
+		statistic::stat_duration handle_time_sum; //handlers consumed time, this indicates the efficiency of msg handling
+	};
+
+	dispatch_pool() {}
+	virtual ~dispatch_pool() {stop();}
+
+	//not thread safe, start and stop the pool before and after msg dispatching.
+	void start(int thread_num)
+	{
+		if (!workers.empty() || thread_num <= 0)
+			return;
+
+		for (auto i = 0; i < thread_num; ++i)
+			workers.emplace_back(new worker());
+		ascs::do_something_to_all(workers, [](std::unique_ptr<worker>& item) {item->start();});
+	}
+
+	//finish all posted handlers and then stop all workers.
+	void stop()
+	{
+		ascs::do_something_to_all(workers, [](std::unique_ptr<worker>& item) {item->stop();});
+		workers.clear();
+	}
+
+	bool started() const {return !workers.empty();}
+	size_t size() const {return workers.size();}
+
+	//the pool must have been started.
+	virtual void post(uint_fast64_t key, std::function<void()>&& handler)
+	{
+		assert(!workers.empty());
+		auto& w = *workers[key % workers.size()];
+		w.queue_depth.fetch_add(1, std::memory_order_relaxed);
+#if ASIO_VERSION >= 101100
+		asio::post(w.io_context_, task(w, std::move(handler)));
+#else
+		w.io_context_.post(task(w, std::move(handler)));
+#endif
+	}
+
+	//like the statistic of sockets, items except queue_depth are only written by the worker itself, read them out of the worker
+	// is not strictly thread safe (see ascs::socket::get_statistic for more details).
+	worker_statistic get_statistic(size_t index) const
+	{
+		assert(index < workers.size());
+		auto& w = *workers[index];
+		auto stat = w.stat;
+		stat.queue_depth = w.queue_depth.load(std::memory_order_relaxed);
+
+		return stat;
+	}
+
+	worker_statistic get_statistic() const
+	{
+		worker_statistic stat;
+		for (size_t i = 0; i < workers.size(); ++i)
+		{
+			auto one = get_statistic(i);
+			stat.queue_depth += one.queue_depth;
+			stat.handled_num += one.handled_num;
+			stat.wait_time_sum += one.wait_time_sum;
+			stat.handle_time_sum += one.handle_time_sum;
+		}
+
+		return stat;
+	}
+
+private:
+	struct worker
+	{
+		worker() : queue_depth(0)
+#if ASIO_VERSION >= 101100
+			, work(io_context_.get_executor())
+#else
+			, work(std::make_shared<asio::io_service::work>(io_context_))
+#endif
+		{}
+
+		void start() {thread_ = std::thread([this]() {this->run();});}
+		void stop() {work.reset(); if (thread_.joinable()) thread_.join();}
+
+		void run()
+		{
+			while (true)
+			{
+#ifdef ASCS_NO_TRY_CATCH
+				io_context_.run();
+				break;
+#else
+				try {io_context_.run(); break;}
+				catch (const std::exception& e) {unified_out::error_out("dispatch worker exception: %s.", e.what());}
+#endif
+			}
+		}
+
+		asio::io_context io_context_;
+		std::atomic_size_t queue_depth;
+		worker_statistic stat; //queue_depth in it is not used
+#if ASIO_VERSION >= 101100
+		asio::executor_work_guard<asio::io_context::executor_type> work;
+#else
+		std::shared_ptr<asio::io_service::work> work;
+#endif
+		std::thread thread_;
+	};
+
+	struct task
+	{
+		task(worker& w_, std::function<void()>&& handler_) : w(&w_), begin_time(statistic::now()), handler(std::move(handler_)) {}
+
+		void operator()()
+		{
+			w->queue_depth.fetch_sub(1, std::memory_order_relaxed);
+			auto now = statistic::now();
+			w->stat.wait_time_sum += now - begin_time;
+			handler();
+			w->stat.handle_time_sum += statistic::now() - now;
+			++w->stat.handled_num;
+		}
+
+		worker* w;
+		statistic::stat_time begin_time;
+		std::function<void()> handler;
+	};
+
+	std::vector<std::unique_ptr<worker>> workers;
+};
+
 class service_pump : public asio::io_context
 {
 public:
@@ -45,6 +197,11 @@ public:
 	protected:
 		virtual bool init() = 0;
 		virtual void uninit() = 0;
+		//called after this service been stopped and all service threads (and the dispatch pool) quit, release resources which are
+		// still used by asynchronous operations, such as threads that call virtual functions of this service.
+		virtual void finalize() {}
+
+		friend class service_pump;
 
 	protected:
 		service_pump& sp;
@@ -61,9 +218,9 @@ public:
 	typedef std::list<object_type> container_type;
 
 #if ASIO_VERSION >= 101200
-	service_pump(int concurrency_hint = ASIO_CONCURRENCY_HINT_SAFE) : asio::io_context(concurrency_hint), started(false)
+	service_pump(int concurrency_hint = ASIO_CONCURRENCY_HINT_SAFE) : asio::io_context(concurrency_hint), started(false), dis_thread_num(0)
 #else
-	service_pump() : started(false)
+	service_pump() : started(false), dis_thread_num(0)
 #endif
 #ifdef ASCS_DECREASE_THREAD_AT_RUNTIME
 		, real_thread_num(0), del_thread_num(0)
@@ -177,6 +334,19 @@ public:
 	bool is_running() const {return !stopped();}
 	bool is_service_started() const {return started;}
 
+	//msg dispatching threads, 0 (the default) means no dispatch pool, the pool will be started before all services and stopped after
+	// all service threads quit, so only call this before start_service or run_service, and only sockets (or object pools) which bound
+	// to get_dispatch_pool() will dispatch msgs in these threads, see ascs::socket::dispatch_executor and ascs::object_pool::dispatch_executor.
+	void dispatch_thread_num(int thread_num) {if (!is_service_started()) dis_thread_num = thread_num;}
+	int dispatch_thread_num() const {return dis_thread_num;}
+	dispatch_pool& get_dispatch_pool() {return dis_pool;}
+	const dispatch_pool& get_dispatch_pool() const {return dis_pool;}
+
+	//global memory budget, sockets (or object pools) which bound to it charge their buffers against it, see ascs::memory_governor,
+	// ascs::socket::mem_governor and ascs::object_pool::mem_governor.
+	memory_governor& get_memory_governor() {return mem_gov;}
+	const memory_governor& get_memory_governor() const {return mem_gov;}
+
 	void add_service_thread(int thread_num) {for (auto i = 0; i < thread_num; ++i) service_threads.emplace_back([this]() {this->run();});}
 #ifdef ASCS_DECREASE_THREAD_AT_RUNTIME
 	void del_service_thread(int thread_num) {if (thread_num > 0) {del_thread_num += thread_num;}}
@@ -194,6 +364,7 @@ protected:
 #else
 		reset(); //this is needed when restart service
 #endif
+		dis_pool.start(dis_thread_num);
 		do_something_to_all([](object_type& item) {item->start_service();});
 		add_service_thread(thread_num);
 	}
@@ -202,6 +373,8 @@ protected:
 	{
 		ascs::do_something_to_all(service_threads, [](std::thread& t) {t.join();});
 		service_threads.clear();
+		dis_pool.stop(); //all services have been stopped, so no more dispatching will be posted
+		do_something_to_all([](object_type& item) {item->finalize();});
 
 		started = false;
 #ifdef ASCS_DECREASE_THREAD_AT_RUNTIME
@@ -215,6 +388,7 @@ protected:
 		assert(nullptr != i_service_);
 
 		i_service_->stop_service();
+		i_service_->finalize();
 		free(i_service_);
 	}
 	virtual void free(object_type i_service_) {} //if needed, rewrite this to free the service
@@ -297,6 +471,9 @@ private:
 	container_type service_can;
 	std::mutex service_can_mutex;
 	std::list<std::thread> service_threads;
+	dispatch_pool dis_pool;
+	int dis_thread_num;
+	memory_governor mem_gov;
 
 #ifdef ASCS_DECREASE_THREAD_AT_RUNTIME
 	std::atomic_int_fast32_t real_thread_num;
@@ -16,13 +16,14 @@
 #include "tracked_executor.h"
 #include "timer.h"
 #include "container.h"
+#include "memory_governor.h"
 
 namespace ascs
 {
 
 template<typename Socket, typename Family, typename Packer, typename Unpacker, typename InMsgType, typename OutMsgType,
 	template<typename> class InQueue, template<typename> class InContainer, template<typename> class OutQueue, template<typename> class OutContainer>
-class socket : public timer<tracked_executor>
+class socket : public timer<tracked_executor>, private i_memory_consumer
 {
 private:
 	typedef timer<tracked_executor> super;
@@ -39,23 +40,76 @@ protected:
 	socket(asio::io_context& io_context_) : super(io_context_), rw_strand(io_context_), next_layer_(io_context_), dis_strand(io_context_) {first_init();}
 	template<typename Arg> socket(asio::io_context& io_context_, Arg&& arg) :
 		super(io_context_), rw_strand(io_context_), next_layer_(io_context_, std::forward<Arg>(arg)), dis_strand(io_context_) {first_init();}
+	~socket()
+	{
+		complete_pending_send_msgs();
+#ifdef ASCS_COROUTINE
+		for (auto& item : co_sb_waiters)
+		{
+			*item.resumer.result = sync_call_result::NOT_APPLICABLE;
+			asio::post(dis_strand.context(), item.resumer);
+		}
+#endif
+		mem_governor(nullptr); //only releases the charged budget, this socket has been detached from the governor when it was closed
+	}
 
 	//helper function, just call it in constructor
 	void first_init()
 	{
 		_id = -1;
+		pool_ = nullptr;
+		dis_executor = nullptr;
+		inbox_ = nullptr;
+		mem_gov = nullptr;
+		mem_charged = 0;
+		mem_paused = false;
 		packer_ = std::make_shared<Packer>();
 		unpacker_ = std::make_shared<Unpacker>();
 		sending = false;
+		send_scheduled = false;
+#ifdef ASCS_SEND_CORK_DELAY
+		corked = false;
+#endif
 #ifdef ASCS_PASSIVE_RECV
 		reading = false;
 #endif
 #ifdef ASCS_SYNC_RECV
+#ifdef ASCS_SYNC_RECV_CHANNEL
+		sr_channel_open = false;
+		sr_consuming = false;
+		sr_waiting = false;
+#else
 		sr_status = sync_recv_status::NOT_REQUESTED;
+#endif
 #endif
 		started_ = false;
+		closing = false;
 		dispatching = false;
+#ifndef ASCS_DISPATCH_BATCH_MSG
+		key_blocked = false;
+		partition_bytes = 0;
+#ifdef ASCS_BACKPRESSURE_POLLING
+		partition_held = false;
+#endif
+#endif
 		recv_idle_began = false;
+#ifdef ASCS_MSG_DEADLINE
+		expiring = false;
+#endif
+#ifdef ASCS_COROUTINE
+		co_receiving = false;
+		co_recv_waiter.handle = nullptr;
+#endif
+#ifndef ASCS_BACKPRESSURE_POLLING
+		recv_suspended = false;
+		dispatch_held = false;
+		dispatch_resumed = false;
+		recv_low_watermark_ = ASCS_RECV_LOW_WATERMARK;
+#endif
+		send_buf_high = false;
+		send_high_watermark_ = ASCS_SEND_HIGH_WATERMARK;
+		send_low_watermark_ = ASCS_SEND_LOW_WATERMARK;
+		sb_waiter_num = 0;
 		send_buf_size_ = ASCS_MAX_SEND_BUF;
 		recv_buf_size_ = ASCS_MAX_RECV_BUF;
 		msg_resuming_interval_ = ASCS_MSG_RESUMING_INTERVAL;
@@ -72,19 +126,43 @@ protected:
 			on_close();
 			set_async_calling(false);
 		}
+		closing = false;
 
 		stat.reset();
 		packer_->reset();
 		unpacker_->reset();
 		sending = false;
+		send_scheduled = false;
+#ifdef ASCS_SEND_CORK_DELAY
+		corked = false;
+#endif
 #ifdef ASCS_PASSIVE_RECV
 		reading = false;
 #endif
 #ifdef ASCS_SYNC_RECV
+#ifdef ASCS_SYNC_RECV_CHANNEL
+		sr_channel_open = false;
+		sr_channel.clear();
+#else
 		sr_status = sync_recv_status::NOT_REQUESTED;
+#endif
 #endif
 		dispatching = false;
 		recv_idle_began = false;
+#ifdef ASCS_MSG_DEADLINE
+		expiring = false;
+#endif
+#ifdef ASCS_COROUTINE
+		co_receiving = false;
+		co_recv_waiter.handle = nullptr;
+#endif
+#ifndef ASCS_BACKPRESSURE_POLLING
+		recv_suspended = false;
+		dispatch_held = false;
+		dispatch_resumed = false;
+#endif
+		mem_paused = false;
+		send_buf_high = false;
 		clear_buffer();
 	}
 
@@ -93,11 +171,23 @@ protected:
 #ifndef ASCS_DISPATCH_BATCH_MSG
 		dispatching_msg.clear();
 #endif
+		complete_pending_send_msgs();
 		send_buffer.clear();
 		recv_buffer.clear();
+		recv_backlog.clear();
+#ifndef ASCS_DISPATCH_BATCH_MSG
+		key_blocked = false;
+#ifdef ASCS_BACKPRESSURE_POLLING
+		partition_held = false;
+#endif
+		ascs::do_something_to_all(partitions, [](std::unique_ptr<dispatch_partition>& item) {item->clear();});
+		partition_bytes = 0;
+#endif
+		update_mem_usage();
 	}
 
 public:
+	typedef Packer packer_type;
 #ifdef ASCS_SYNC_SEND
 	typedef obj_with_begin_time_promise<InMsgType> in_msg;
 #else
@@ -124,13 +214,19 @@ public:
 	virtual int type_id() const = 0;
 
 	bool started() const {return started_;}
+	//the closing procedure (see close) has begun but not finished yet, object_pool will be informed after it finished.
+	bool is_closing() const {return closing;}
 	void start()
 	{
 		if (!started_ && !is_timer(TIMER_DELAY_CLOSE) && !stopped())
 		{
 			scope_atomic_lock lock(start_atomic);
 			if (!started_ && lock.locked())
+			{
 				started_ = do_start();
+				if (started_)
+					attach_mem_governor(true);
+			}
 			else
 				unified_out::error_out(ASCS_LLF " starting failed.", id());
 		}
@@ -140,16 +236,29 @@ public:
 
 #ifdef ASCS_PASSIVE_RECV
 	bool is_reading() const {return reading;}
-	void recv_msg() {if (!reading && is_ready()) dispatch_strand(rw_strand, [this]() {this->do_recv_msg();});}
+	void recv_msg() {if (!reading && is_ready()) dispatch_strand(rw_strand, [this]() {if (this->flush_recv_backlog()) this->do_recv_msg();});}
 #else
 private:
-	void recv_msg() {dispatch_strand(rw_strand, [this]() {this->do_recv_msg();});}
+	void recv_msg() {dispatch_strand(rw_strand, [this]() {if (this->flush_recv_backlog()) this->do_recv_msg();});}
 public:
 #endif
 #ifndef ASCS_EXPOSE_SEND_INTERFACE
 private:
 #endif
-	void send_msg() {if (!sending && is_ready()) dispatch_strand(rw_strand, [this]() {this->do_send_msg();});}
+	void send_msg()
+	{
+		if (!sending && is_ready())
+		{
+			//only the first sender rings the doorbell, others' msgs will be sent by the same do_send_msg invocation, after it cleared the
+			// doorbell, it will see all msgs which were pushed into the sending buffer by senders who didn't ring the doorbell.
+			if (!send_scheduled.exchange(true, std::memory_order_acq_rel))
+				dispatch_strand(rw_strand, [this]() {this->send_scheduled.exchange(false, std::memory_order_acq_rel); this->do_send_msg();});
+		}
+#ifdef ASCS_SEND_CORK_DELAY
+		else if (corked && send_buffer.size_in_byte() >= ASCS_SEND_CORK_SIZE)
+			uncork();
+#endif
+	}
 
 public:
 	void start_heartbeat(int interval, int max_absence = ASCS_HEARTBEAT_MAX_ABSENCE)
@@ -191,10 +300,12 @@ public:
 	void send_buf_size(size_t size) {if (size > 0) send_buf_size_ = size;}
 	size_t send_buf_size() const {return send_buf_size_;}
 	float send_buf_usage() const {return (float) send_buffer.size_in_byte() / send_buf_size_;}
+	//only available if the input queue has lanes (for example multi_lane_queue), so are other functions which accept lane
+	float send_buf_usage(const lane& l) const {return (float) send_buffer.size_in_byte(l) / send_buf_size_;}
 
 	void recv_buf_size(size_t size) {if (size > 0) recv_buf_size_ = size;}
 	size_t recv_buf_size() const {return recv_buf_size_;}
-	float recv_buf_usage() const {return (float) recv_buffer.size_in_byte() / recv_buf_size_;}
+	float recv_buf_usage() const {return (float) recv_size_in_byte() / recv_buf_size_;}
 
 	void msg_resuming_interval(unsigned interval) {msg_resuming_interval_ = interval;}
 	unsigned msg_resuming_interval() const {return msg_resuming_interval_;}
@@ -202,6 +313,96 @@ public:
 	void msg_handling_interval(size_t interval) {msg_handling_interval_ = interval;}
 	size_t msg_handling_interval() const {return msg_handling_interval_;}
 
+	//dispatch msgs (call on_msg_handle) in the specified executor rather than in service threads (via strand), null means service threads,
+	// the executor must outlive this socket, and it must guarantee that handlers with the same key run one by one and in order (actor
+	// style), only call this before start (or after close), ascs::object_pool::dispatch_executor does it for all sockets it creates.
+	void dispatch_executor(i_dispatch_executor* executor) {dis_executor = executor;}
+	i_dispatch_executor* dispatch_executor() const {return dis_executor;}
+
+	//push msgs into inbox_ rather than the receiving buffer, on_msg_handle will never be invoked, and message receiving will be suspended
+	// when inbox_ is full, the inbox must outlive this socket, only call this before start (or after close),
+	// ascs::object_pool::inbox_consumer_num does it for all sockets it creates.
+	void inbox(i_inbox<OutMsgType>* inbox) {inbox_ = inbox;}
+	i_inbox<OutMsgType>* inbox() const {return inbox_;}
+	//called by the inbox after it's been drained (with macro ASCS_BACKPRESSURE_POLLING, a timer does this), it's harmless if message
+	// receiving has not been suspended, and it can be called in any thread.
+#ifndef ASCS_BACKPRESSURE_POLLING
+	void resume_recv() {check_resuming_recv();}
+#else
+	void resume_recv() {}
+#endif
+
+	//charge the sending and receiving buffers against the governor (see memory_governor for more details), null means no global limitation,
+	// the governor must outlive this socket, only call this before start (or after close), ascs::object_pool::mem_governor does it for
+	// all sockets it creates. per-socket usage is get_pending_send_msg_size() + get_pending_recv_msg_size() + msgs in dispatch partitions.
+	//buffers are charged as long as the governor is set, but the policy only applies to started sockets, a socket registers itself to
+	// the governor when it's started and unregisters when it's closed, so a closed socket (which may be freed) is never called by the governor.
+	void mem_governor(memory_governor* governor)
+	{
+		if (governor == mem_gov)
+			return;
+		else if (nullptr != mem_gov)
+		{
+			attach_mem_governor(false);
+			mem_gov->release(mem_charged.exchange(0));
+		}
+
+		mem_paused = false;
+		mem_gov = governor;
+		if (nullptr != mem_gov)
+		{
+			if (started_)
+				attach_mem_governor(true);
+			update_mem_usage();
+		}
+	}
+	memory_governor* mem_governor() const {return mem_gov;}
+
+#ifndef ASCS_DISPATCH_BATCH_MSG
+	typedef std::function<uint_fast64_t(const OutMsgType&)> key_extractor;
+	//dispatch msgs concurrently by keys, msgs are hashed to partition_num partitions by extractor's return value, partitions are dispatched in
+	// the dispatch executor (or service threads if it's null) concurrently, while msgs in the same partition (so with the same key) are still
+	// dispatched one by one and in order, so on_msg_handle must be thread safe after this call, and one msg with on_msg_handle failed only
+	// holds its own partition (retried like before, see resume_dispatch).
+	//each partition buffers up to recv_buf_size() / partition_num bytes of msgs, if a msg's partition is full, msgs after it will be left in the
+	// receiving buffer until the partition been drained, so a slow key will eventually suspend message receiving as before.
+	//msgs in partitions are charged against recv_buf_size() (and the memory governor, and credits) together with the receiving buffer,
+	// so the receiving buffer plus all partitions hold at most recv_buf_size() bytes (plus one msg) before message receiving been suspended.
+	//with a dispatch executor, the feeder still posts with socket id as the key, and partitions post with keys mixed from socket id and their
+	// indexes (see partition_key), so they don't overlap the keys of other sockets.
+	//not thread safe, only call this before start (or after close), empty extractor restores the default behavior.
+	void dispatch_by_key(const key_extractor& extractor, size_t partition_num = ASCS_DISPATCH_PARTITION_NUM)
+	{
+		assert(!started_);
+
+		partitions.clear();
+		partition_bytes = 0;
+		extractor_ = extractor;
+		if (extractor_)
+			for (size_t i = 0; i < std::max(partition_num, (size_t) 1); ++i)
+				partitions.emplace_back(new dispatch_partition(i));
+	}
+	bool is_dispatching_by_key() const {return !partitions.empty();}
+#endif
+
+#ifndef ASCS_BACKPRESSURE_POLLING
+	void recv_low_watermark(float watermark) {if (watermark >= 0.f && watermark < 1.f) recv_low_watermark_ = watermark;}
+	float recv_low_watermark() const {return recv_low_watermark_;}
+
+	//after on_msg_handle returned false (or 0 with macro ASCS_DISPATCH_BATCH_MSG), msg handling will be held until this function been called,
+	//call it after the condition which blocked msg handling has gone, it can be called in any thread and at any time (it's harmless if msg
+	// handling is not being held), if it's called during on_msg_handle which is going to fail, msg handling will be retried immediately.
+	//ascs calls it after each successful write.
+	void resume_dispatch()
+	{
+		dispatch_resumed = true;
+		if (dispatch_held && dispatch_held.exchange(false))
+			post_dispatch_msg();
+	}
+#else
+	void resume_dispatch() {} //msg handling will be retried after msg_handling_interval() milliseconds
+#endif
+
 	//in ascs, it's thread safe to access stat without mutex, because for a specific member of stat, ascs will never access it concurrently.
 	//but user can access stat out of ascs via get_statistic function, although user can only read it, there's still a potential risk (especially
 	// on 32 bit system, most likely, it will not be thread safe), so whether it's thread safe or not depends on std::chrono::system_clock::duration.
@@ -229,17 +430,66 @@ public:
 
 	//if you use can_overflow = true to invoke send_msg or send_native_msg, it will always succeed no matter the sending buffer is overflow or not,
 	//this can exhaust all virtual memory, please pay special attentions.
-	bool is_send_buffer_available() const {return send_buffer.size_in_byte() < send_buf_size_;}
+	bool is_send_buffer_available() const {return send_buffer.size_in_byte() < send_buf_size_ && (nullptr == mem_gov || !mem_gov->is_rejecting());}
+
+	//block until the sending buffer becomes available (see is_send_buffer_available), this socket been closed (NOT_APPLICABLE returned)
+	// or duration milliseconds elapsed (TIMEOUT returned, 0 means wait infinitely), waiters are woken up after each successful write,
+	// so they will be woken up as soon as the sending buffer has room. can be called in any thread except service threads.
+	//since waiters are not woken up when the memory governor recovered, use a finite duration if the governor can reject msgs.
+	sync_call_result wait_send_buffer_available(unsigned duration = 0)
+	{
+		if (!started_)
+			return sync_call_result::NOT_APPLICABLE;
+		else if (is_send_buffer_available())
+			return sync_call_result::SUCCESS;
+
+		std::unique_lock<std::mutex> lock(sb_mutex);
+		++sb_waiter_num;
+		std::atomic_thread_fence(std::memory_order_seq_cst); //either we see the room or notify_send_buffer_waiters sees sb_waiter_num
+		auto pred = [this]() {return !this->started_ || this->is_send_buffer_available();};
+		auto re = true;
+		if (0 == duration)
+			sb_cv.wait(lock, std::move(pred));
+		else
+			re = sb_cv.wait_for(lock, std::chrono::milliseconds(duration), std::move(pred));
+		--sb_waiter_num;
+
+		return !re ? sync_call_result::TIMEOUT : started_ ? sync_call_result::SUCCESS : sync_call_result::NOT_APPLICABLE;
+	}
+
+	//on_send_buffer_high will be invoked when the usage of the sending buffer (see send_buf_usage()) rose to or above the high watermark,
+	// and then on_send_buffer_low will be invoked when it dropped to or below the low watermark, see macro ASCS_SEND_HIGH_WATERMARK and
+	// ASCS_SEND_LOW_WATERMARK for more details.
+	void send_watermarks(float high, float low) {if (high > 0.f && low >= 0.f && low < high) {send_high_watermark_ = high; send_low_watermark_ = low;}}
+	float send_high_watermark() const {return send_high_watermark_;}
+	float send_low_watermark() const {return send_low_watermark_;}
 
 	//if you define macro ASCS_PASSIVE_RECV and call recv_msg greedily, the receiving buffer may overflow, this can exhaust all virtual memory,
 	//to avoid this problem, call recv_msg only if is_recv_buffer_available() returns true.
-	bool is_recv_buffer_available() const {return recv_buffer.size_in_byte() < recv_buf_size_;}
+	bool is_recv_buffer_available() const {return recv_size_in_byte() < recv_buf_size_ && !ascs::is_full(recv_buffer, 0) && is_recv_admitted();}
 
 	//don't use the packer but insert into send buffer directly
 	template<typename T> bool direct_send_msg(T&& msg, bool can_overflow = false, bool prior = false)
 		{return can_overflow || shrink_send_buffer() ? do_direct_send_msg(std::forward<T>(msg), prior) : false;}
 	bool direct_send_msg(std::list<InMsgType>& msg_can, bool can_overflow = false, bool prior = false)
 		{return can_overflow || shrink_send_buffer() ? do_direct_send_msg(msg_can, prior) : false;}
+	template<typename T> bool direct_send_msg(T&& msg, const lane& l, bool can_overflow = false)
+		{return can_overflow || shrink_send_buffer() ? do_direct_send_msg(std::forward<T>(msg), l) : false;}
+	bool direct_send_msg(std::list<InMsgType>& msg_can, const lane& l, bool can_overflow = false)
+		{return can_overflow || shrink_send_buffer() ? do_direct_send_msg(msg_can, l) : false;}
+#ifdef ASCS_MSG_DEADLINE
+	template<typename T> bool direct_send_msg(T&& msg, const deadline& d, bool can_overflow = false)
+		{return can_overflow || shrink_send_buffer() ? do_direct_send_msg(std::forward<T>(msg), d) : false;}
+	bool direct_send_msg(std::list<InMsgType>& msg_can, const deadline& d, bool can_overflow = false)
+		{return can_overflow || shrink_send_buffer() ? do_direct_send_msg(msg_can, d) : false;}
+#endif
+#ifdef ASCS_SYNC_SEND
+	//c's callback will be invoked after the msg(s) been sent or failed, see struct completion
+	template<typename T> bool direct_send_msg(T&& msg, const completion& c, bool can_overflow = false)
+		{return can_overflow || shrink_send_buffer() ? do_direct_send_msg(std::forward<T>(msg), c) : false;}
+	bool direct_send_msg(std::list<InMsgType>& msg_can, const completion& c, bool can_overflow = false)
+		{return can_overflow || shrink_send_buffer() ? do_direct_send_msg(msg_can, c) : false;}
+#endif
 
 #ifdef ASCS_SYNC_SEND
 	//don't use the packer but insert into send buffer directly, then wait the sending to finish, unit of the duration is millisecond, 0 means wait infinitely
@@ -247,9 +497,32 @@ public:
 		{return can_overflow || shrink_send_buffer() ? do_direct_sync_send_msg(std::forward<T>(msg), duration, prior) : sync_call_result::NOT_APPLICABLE;}
 	sync_call_result direct_sync_send_msg(std::list<InMsgType>& msg_can, unsigned duration = 0, bool can_overflow = false, bool prior = false)
 		{return can_overflow || shrink_send_buffer() ? do_direct_sync_send_msg(msg_can, duration, prior) : sync_call_result::NOT_APPLICABLE;}
+	template<typename T> sync_call_result direct_sync_send_msg(T&& msg, const lane& l, unsigned duration = 0, bool can_overflow = false)
+		{return can_overflow || shrink_send_buffer() ? do_direct_sync_send_msg(std::forward<T>(msg), duration, l) : sync_call_result::NOT_APPLICABLE;}
+	sync_call_result direct_sync_send_msg(std::list<InMsgType>& msg_can, const lane& l, unsigned duration = 0, bool can_overflow = false)
+		{return can_overflow || shrink_send_buffer() ? do_direct_sync_send_msg(msg_can, duration, l) : sync_call_result::NOT_APPLICABLE;}
 #endif
 
 #ifdef ASCS_SYNC_RECV
+#ifdef ASCS_SYNC_RECV_CHANNEL
+	//take all batches of msgs in the channel, see macro ASCS_SYNC_RECV_CHANNEL for more details.
+	sync_call_result sync_recv_msg(std::list<OutMsgType>& msg_can, unsigned duration = 0) //unit of the duration is millisecond, 0 means wait infinitely
+	{
+		if (stopped())
+			return sync_call_result::NOT_APPLICABLE;
+		else if (sr_consuming.exchange(true))
+			return sync_call_result::DUPLICATE;
+
+		sr_channel_open = true;
+#ifdef ASCS_PASSIVE_RECV
+		recv_msg();
+#endif
+		auto re = sync_recv_draining(msg_can, duration);
+		sr_consuming = false;
+
+		return re;
+	}
+#else
 	sync_call_result sync_recv_msg(std::list<OutMsgType>& msg_can, unsigned duration = 0) //unit of the duration is millisecond, 0 means wait infinitely
 	{
 		if (stopped())
@@ -273,6 +546,34 @@ public:
 		return re;
 	}
 #endif
+#endif
+
+#ifdef ASCS_COROUTINE
+	ASCS_CO_SEND_MSG(async_direct_send, direct_send_msg) //co_await async_direct_send(msg), see macro ASCS_COROUTINE
+
+	//co_await async_recv_batch() returns std::list<OutMsgType>, which takes all msgs in the receiving buffer (at least one), an empty list
+	// means the socket has been closed (or not started), the coroutine is resumed in the dispatcher (dis_strand or dis_executor).
+	//after the first invocation, on_msg_handle will not be invoked any more (until this socket been reset), msgs will be kept in the
+	// receiving buffer until the next invocation, so the backpressure still works. only one coroutine can await it at the same time,
+	// and don't use it with dispatch_by_key.
+	auto async_recv_batch()
+	{
+		return make_co_awaitable<std::list<OutMsgType>>([this](const co_resumer<std::list<OutMsgType>>& resumer) {
+			this->co_receiving = true; //before the registration, so msgs arrive in the meantime will not be dispatched to on_msg_handle
+#ifdef ASCS_PASSIVE_RECV
+			this->recv_msg();
+#endif
+			if (nullptr == this->dis_executor && this->dis_strand.running_in_this_thread())
+				return this->co_recv_msg(resumer); //already in the dispatcher, no context switch
+			else if (nullptr == this->dis_executor)
+				this->post_strand(this->dis_strand, [this, resumer]() {if (!this->co_recv_msg(resumer)) resumer();});
+			else
+				this->dis_executor->post(this->_id, this->make_handler([this, resumer]() {if (!this->co_recv_msg(resumer)) resumer();}));
+
+			return true;
+		});
+	}
+#endif
 
 	//how many msgs waiting for sending or dispatching
 	GET_PENDING_MSG_SIZE(get_pending_send_msg_size, send_buffer)
@@ -355,14 +656,132 @@ protected:
 	//notice: the msg is packed, using inconstant reference is for the ability of swapping
 	virtual void on_all_msg_send(InMsgType& msg) = 0;
 #endif
+#ifdef ASCS_MSG_DEADLINE
+	//msgs in msg_can reached their deadlines before being sent, they will be dropped after this callback (in rw_strand),
+	// if you still want to send them, swap msg_can's content with your own container and re-send them via direct_send_msg.
+	virtual void on_msg_expire(in_container_type& msg_can) {}
+
+	//must be called in rw_strand and in sending order, items which follow an expired item expire too.
+	bool is_expired(const in_msg& msg, const std::chrono::steady_clock::time_point& now) {return msg.follows_prev() ? expiring : (expiring = msg.expired(now));}
+
+	//must be called in rw_strand, return true if some msgs have been dropped.
+	bool drop_expired_msgs(in_container_type& msg_can)
+	{
+		in_container_type expired_msgs;
+		auto now = std::chrono::steady_clock::now();
+		for (auto iter = std::begin(msg_can); iter != std::end(msg_can);)
+			if (is_expired(*iter, now))
+			{
+				auto next = std::next(iter);
+				expired_msgs.splice(std::end(expired_msgs), msg_can, iter, next);
+				iter = next;
+			}
+			else
+				++iter;
+
+		return expire_msgs(expired_msgs);
+	}
+
+	bool expire_msgs(in_container_type& msg_can) //count and notify, return false if msg_can is empty
+	{
+		if (msg_can.empty())
+			return false;
+
+		stat.send_expired_msg_sum += msg_can.size();
+		stat.send_expired_byte_sum += ascs::get_size_in_byte(msg_can);
+#ifdef ASCS_SYNC_SEND
+		ascs::do_something_to_all(msg_can, [](in_msg& item) {item.complete(sync_call_result::NOT_APPLICABLE);});
+#endif
+		on_msg_expire(msg_can);
+		return true;
+	}
+#endif
+
+	//the memory governor dropped all msgs in the sending buffer because of policy memory_governor::policy::SHED_LARGEST, msgs will be
+	// freed after this callback, if you still want to send them, swap msg_can's content with your own container.
+	//it's invoked in the thread which triggered the shedding (see i_memory_consumer), not in any strand of this socket, so it can be
+	// invoked concurrently with other callbacks (on_msg_send for example), synchronize by yourself or post your work to a strand.
+	virtual void on_msg_shed(in_container_type& msg_can) {}
+
+	//the usage of the sending buffer crossed the watermarks (see send_watermarks), invoked in rw_strand after a write completed and alternately,
+	// so producers can pause sending in on_send_buffer_high and resume it in on_send_buffer_low rather than polling the sending buffer.
+	virtual void on_send_buffer_high() {}
+	virtual void on_send_buffer_low() {}
+
+	//must be called in rw_strand after a write completed and the following msgs been moved out of the sending buffer, peak_usage is the size
+	// of the sending buffer before that (msgs accumulated during the write).
+	void check_send_buffer(size_t peak_usage)
+	{
+		if (!send_buf_high && (float) peak_usage / send_buf_size_ >= send_high_watermark_)
+		{
+			send_buf_high = true;
+			on_send_buffer_high();
+		}
+
+		if (send_buf_high && send_buf_usage() <= send_low_watermark_)
+		{
+			send_buf_high = false;
+			on_send_buffer_low();
+		}
+
+		notify_send_buffer_waiters();
+	}
+
+	void notify_send_buffer_waiters()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst); //pairs with the fence in wait_send_buffer_available (and co_safe_send)
+		if (sb_waiter_num.load(std::memory_order_relaxed) > 0)
+		{
+			std::unique_lock<std::mutex> lock(sb_mutex);
+			sb_cv.notify_all();
+#ifdef ASCS_COROUTINE
+			if (!co_sb_waiters.empty())
+			{
+				std::list<co_sb_waiter> waiters;
+				waiters.swap(co_sb_waiters);
+				sb_waiter_num -= waiters.size();
+				lock.unlock();
+
+				for (auto& item : waiters)
+					post_resume(std::move(item.retry));
+			}
+#endif
+		}
+	}
+
+	//sync the usage of the sending and receiving buffers to the memory governor (if any), call it after msgs been moved in or out.
+	void update_mem_usage()
+	{
+		if (nullptr == mem_gov)
+			return;
+
+		auto usage = send_buffer.size_in_byte() + recv_size_in_byte();
+		auto charged = mem_charged.exchange(usage, std::memory_order_relaxed);
+		if (usage > charged)
+			mem_gov->charge(usage - charged);
+		else if (usage < charged)
+			mem_gov->release(charged - usage);
+	}
+
+	//msgs left in the sending buffer will not be sent unless this socket been restarted (reconnecting for example), so complete them (if they
+	// carry completions) with NOT_APPLICABLE after closing, and before they been freed (reset and destruction), but keep them in the buffer.
+	void complete_pending_send_msgs()
+	{
+#ifdef ASCS_SYNC_SEND
+		send_buffer.do_something_to_all([](in_msg& item) {item.complete(sync_call_result::NOT_APPLICABLE);});
+#endif
+	}
 
 	//return true means send buffer becomes available
 #ifdef ASCS_SHRINK_SEND_BUFFER
 	virtual size_t calc_shrink_size(size_t current_size) {return current_size / 3;}
-	virtual void on_msg_discard(in_container_type& msg_can) {}
+	virtual void on_msg_discard(in_container_type& msg_can) {} //completions (if any) have been invoked with NOT_APPLICABLE
 
 	bool shrink_send_buffer()
 	{
+		if (nullptr != mem_gov && mem_gov->is_rejecting())
+			return false;
+
 		send_buffer.lock();
 		auto size = send_buffer.size_in_byte();
 		if (size < send_buf_size_)
@@ -379,7 +798,11 @@ protected:
 		in_container_type msg_can;
 		send_buffer.move_items_out_(size, msg_can);
 		send_buffer.unlock();
+		update_mem_usage();
 
+#ifdef ASCS_SYNC_SEND
+		ascs::do_something_to_all(msg_can, [](in_msg& item) {item.complete(sync_call_result::NOT_APPLICABLE);});
+#endif
 		on_msg_discard(msg_can);
 		return true;
 	}
@@ -399,10 +822,19 @@ protected:
 		if (!started_)
 			return false;
 
+		closing = true; //before started_, so object_pool never sees a socket neither started nor closing before it finished closing
 		started_ = false;
+		attach_mem_governor(false); //the governor will not call this socket any more (it may be reused or freed after closed)
 #ifdef ASCS_SYNC_RECV
+#ifdef ASCS_SYNC_RECV_CHANNEL
+		{std::lock_guard<std::mutex> lock(sync_recv_mutex);} //sync_recv_msg either sees started_ been false or is waiting on sync_recv_cv
+#endif
 		sync_recv_cv.notify_all();
 #endif
+#ifdef ASCS_COROUTINE
+		dispatch_msg(); //wake up the coroutine which is awaiting async_recv_batch
+#endif
+		notify_send_buffer_waiters(); //wait_send_buffer_available either sees started_ been false or is waiting on sb_cv
 		stop_all_timer();
 
 		if (lowest_layer().is_open())
@@ -418,6 +850,11 @@ protected:
 			unpacker_->reset(); //very important, otherwise, the unpacker will never be able to parse any more messages if its buffer has legacy data
 			on_close();
 			after_close();
+			if (!started_) //not restarted (reconnecting for example)
+				complete_pending_send_msgs();
+			closing = false;
+			if (nullptr != pool_)
+				pool_->on_obsoleted(_id);
 		}
 		else
 		{
@@ -430,7 +867,7 @@ protected:
 
 	void handle_error()
 	{
-#ifdef ASCS_SYNC_RECV
+#if defined(ASCS_SYNC_RECV) && !defined(ASCS_SYNC_RECV_CHANNEL)
 		std::unique_lock<std::mutex> lock(sync_recv_mutex);
 		if (sync_recv_status::REQUESTED == sr_status)
 		{
@@ -449,6 +886,24 @@ protected:
 		stat.recv_msg_sum += size;
 		stat.recv_byte_sum += size_in_byte;
 #ifdef ASCS_SYNC_RECV
+#ifdef ASCS_SYNC_RECV_CHANNEL
+		if (sr_channel_open)
+		{
+			//hand the batch over and continue reading immediately, if the channel is full (only possible if recv_msg was called manually with
+			// macro ASCS_PASSIVE_RECV), temp_msg_can will be kept and the next batch will be appended to it, see is_recv_admitted.
+			if (!temp_msg_can.empty() && sr_channel.push(temp_msg_can))
+			{
+				std::atomic_thread_fence(std::memory_order_seq_cst); //pairs with the one in sync_recv_draining
+				if (sr_waiting.load(std::memory_order_relaxed))
+				{
+					std::lock_guard<std::mutex> lock(sync_recv_mutex);
+					sync_recv_cv.notify_one();
+				}
+			}
+
+			return handled_msg();
+		}
+#else
 		std::unique_lock<std::mutex> lock(sync_recv_mutex);
 		if (sync_recv_status::REQUESTED == sr_status)
 		{
@@ -462,6 +917,7 @@ protected:
 				return handled_msg(); //sync_recv_msg() has consumed temp_msg_can
 		}
 		lock.unlock();
+#endif
 #endif
 		auto empty = temp_msg_can.empty();
 #ifdef ASCS_SYNC_DISPATCH
@@ -483,26 +939,67 @@ protected:
 			temp_msg_can.emplace_back(); //empty message, let user always having the chance to call recv_msg()
 		}
 #endif
-		if (!empty)
+		if (!empty && nullptr != inbox_)
+		{
+			if (0 == size_in_byte)
+				size_in_byte = ascs::get_size_in_byte(temp_msg_can);
+			inbox_->push(_id, temp_msg_can, size_in_byte); //if the inbox is full, handled_msg will suspend message receiving
+			temp_msg_can.clear();
+		}
+		else if (!empty)
 		{
-			out_container_type temp_buffer;
+			if (!recv_backlog.empty())
+				size_in_byte = 0; //the backlog goes first
 			for (auto iter = temp_msg_can.begin(); iter != temp_msg_can.end(); ++iter)
-				temp_buffer.emplace_back(std::move(*iter));
+				recv_backlog.emplace_back(std::move(*iter));
 			temp_msg_can.clear();
 
-			recv_buffer.move_items_in(temp_buffer, size_in_byte);
-			dispatch_msg();
+			return move_recv_msgs_in(size_in_byte);
 		}
 
 		return handled_msg();
 	}
 
-	template<typename T> bool do_direct_send_msg(T&& msg, bool prior = false)
+	//a bounded receiving buffer (like spsc_queue) leaves msgs which it cannot hold in recv_backlog, then message receiving will be suspended
+	// (see is_recv_buffer_available) until the dispatcher made room for them, and they will be moved in before the next reading.
+	bool move_recv_msgs_in(size_t size_in_byte = 0)
+	{
+		for (;; size_in_byte = 0)
+		{
+			recv_buffer.move_items_in(recv_backlog, size_in_byte);
+			update_mem_usage();
+			dispatch_msg();
+
+			auto re = handled_msg();
+			if (!re || recv_backlog.empty())
+				return re;
+		}
+	}
+
+	//return false if the backlog cannot be moved in completely, then don't read.
+	bool flush_recv_backlog()
+	{
+		if (recv_backlog.empty())
+			return true;
+#ifdef ASCS_PASSIVE_RECV
+		move_recv_msgs_in(); //handled_msg always returns false with macro ASCS_PASSIVE_RECV
+		return recv_backlog.empty();
+#else
+		return move_recv_msgs_in();
+#endif
+	}
+
+	//Prior can be bool (put msgs at the front of the send buffer or not), lane (put msgs into the specified lane), deadline (with macro
+	// ASCS_MSG_DEADLINE) or completion (with macro ASCS_SYNC_SEND)
+	template<typename T, typename Prior = bool> bool do_direct_send_msg(T&& msg, const Prior& prior = false)
 	{
 		if (msg.empty())
 			unified_out::error_out(ASCS_LLF " found an empty message, please check your packer.", id());
-		else if (prior ? send_buffer.enqueue_front(std::forward<T>(msg)) : send_buffer.enqueue(std::forward<T>(msg)))
+		else if (enqueue_send_msg(std::forward<T>(msg), prior))
+		{
+			update_mem_usage();
 			send_msg();
+		}
 
 		//even if we meet an empty message (because of too big message or insufficient memory, most likely), we still return true, why?
 		//please think about the function safe_send_(native_)msg, if we keep returning false, it will enter a dead loop.
@@ -510,19 +1007,54 @@ protected:
 		return true;
 	}
 
-	bool do_direct_send_msg(std::list<InMsgType>& msg_can, bool prior = false)
+	template<typename Prior = bool> bool do_direct_send_msg(std::list<InMsgType>& msg_can, const Prior& prior = false)
 	{
 		size_t size_in_byte = 0;
 		in_container_type temp_buffer;
 		ascs::do_something_to_all(msg_can, [&size_in_byte, &temp_buffer](InMsgType& msg) {size_in_byte += msg.size(); temp_buffer.emplace_back(std::move(msg));});
-		prior ? send_buffer.move_items_in_front(temp_buffer, size_in_byte) : send_buffer.move_items_in(temp_buffer, size_in_byte);
+		move_send_msgs_in(temp_buffer, size_in_byte, prior);
+		update_mem_usage();
 		send_msg();
 
 		return true;
 	}
 
+#ifdef ASCS_COROUTINE
+	//Sender (bool(const completion&)) sends msgs with the completion, it will be invoked only once, see macro ASCS_CO_SEND_MSG.
+	template<typename Sender> auto co_send_msg(Sender&& sender)
+	{
+		return make_co_awaitable<sync_call_result>([this, sender(std::forward<Sender>(sender))](const co_resumer<sync_call_result>& resumer) mutable {
+			auto c = make_send_completion<co_send_completion>(*this, resumer);
+			if (!sender(completion(c)))
+				c->complete(sync_call_result::NOT_APPLICABLE);
+
+			return true;
+		});
+	}
+
+	//like co_send_msg, but invoke Sender only if the sending buffer is available (see is_send_buffer_available), otherwise, suspend the
+	// coroutine until the buffer has room (waiters are retried in the dispatcher after each successful write, just like
+	// wait_send_buffer_available), or resume it with NOT_APPLICABLE if this socket is not ready (or been closed).
+	//since waiters are not woken up when the memory governor recovered, the coroutine may be suspended until the next write completed.
+	template<typename Sender> auto co_safe_send_msg(Sender&& sender)
+	{
+		auto s = std::make_shared<typename std::decay<Sender>::type>(std::forward<Sender>(sender)); //waiters must be copyable
+		return make_co_awaitable<sync_call_result>([this, s](const co_resumer<sync_call_result>& resumer) {return this->co_safe_send(s, resumer);});
+	}
+
+	//resume coroutines (or run other handlers for them) in the dispatcher, so they are serialized with msg dispatching (and each other) on
+	// this socket.
+	template<typename Handler> void post_resume(Handler handler)
+	{
+		if (nullptr == dis_executor)
+			post_strand(dis_strand, std::move(handler));
+		else
+			dis_executor->post(_id, make_handler(std::move(handler)));
+	}
+#endif
+
 #ifdef ASCS_SYNC_SEND
-	template<typename T> sync_call_result do_direct_sync_send_msg(T&& msg, unsigned duration = 0, bool prior = false)
+	template<typename T, typename Prior = bool> sync_call_result do_direct_sync_send_msg(T&& msg, unsigned duration = 0, const Prior& prior = false)
 	{
 		if (stopped())
 			return sync_call_result::NOT_APPLICABLE;
@@ -532,17 +1064,19 @@ protected:
 			return sync_call_result::SUCCESS;
 		}
 
-		auto unused = in_msg(std::forward<T>(msg), true);
-		auto p = unused.p;
-		auto f = p->get_future();
-		if (!(prior ? send_buffer.enqueue_front(std::move(unused)) : send_buffer.enqueue(std::move(unused))))
+		auto waiter = make_send_completion<sync_send_waiter>();
+		auto state = waiter->get_state(); //only the msg holds the waiter, see sync_send_waiter
+		in_msg unused(std::forward<T>(msg));
+		unused.p = std::move(waiter);
+		if (!enqueue_send_msg(std::move(unused), prior))
 			return sync_call_result::NOT_APPLICABLE;
 
+		update_mem_usage();
 		send_msg();
-		return 0 == duration || std::future_status::ready == f.wait_for(std::chrono::milliseconds(duration)) ? f.get() : sync_call_result::TIMEOUT;
+		return state->wait(duration);
 	}
 
-	sync_call_result do_direct_sync_send_msg(std::list<InMsgType>& msg_can, unsigned duration = 0, bool prior = false)
+	template<typename Prior = bool> sync_call_result do_direct_sync_send_msg(std::list<InMsgType>& msg_can, unsigned duration = 0, const Prior& prior = false)
 	{
 		if (stopped())
 			return sync_call_result::NOT_APPLICABLE;
@@ -553,27 +1087,244 @@ protected:
 		in_container_type temp_buffer;
 		ascs::do_something_to_all(msg_can, [&size_in_byte, &temp_buffer](InMsgType& msg) {size_in_byte += msg.size(); temp_buffer.emplace_back(std::move(msg));});
 
-		temp_buffer.back().check_and_create_promise(true);
-		auto p = temp_buffer.back().p;
-		auto f = p->get_future();
-		prior ? send_buffer.move_items_in_front(temp_buffer, size_in_byte) : send_buffer.move_items_in(temp_buffer, size_in_byte);
+		auto waiter = make_send_completion<sync_send_waiter>();
+		auto state = waiter->get_state(); //only the msg holds the waiter, see sync_send_waiter
+		temp_buffer.back().p = std::move(waiter); //the last item completes the whole msg
+		move_send_msgs_in(temp_buffer, size_in_byte, prior);
+		update_mem_usage();
 
 		send_msg();
-		return 0 == duration || std::future_status::ready == f.wait_for(std::chrono::milliseconds(duration)) ? f.get() : sync_call_result::TIMEOUT;
+		return state->wait(duration);
 	}
 #endif
 
 private:
 	virtual void do_recv_msg() = 0;
 	virtual bool do_send_msg(bool in_strand = false) = 0;
+#ifdef ASCS_SEND_CORK_DELAY
+	virtual void uncork() {} //release the cork (if corked) and send msgs immediately, see macro ASCS_SEND_CORK_DELAY
+#endif
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	virtual void grant_credit() {} //grant new credits to the peer if the receiving buffer drained enough, see macro ASCS_CREDIT_FLOW_CONTROL
+#endif
 
 	//please do not change id at runtime via the following function, except this socket is not managed by object_pool,
 	//it should only be used by object_pool when reusing or creating new socket.
-	template<typename> friend class object_pool;
+	template<typename, typename> friend class object_pool;
 	template<typename> friend class single_socket_service;
 	void id(uint_fast64_t id) {_id = id;}
+	void pool(i_object_pool* pool) {pool_ = pool;}
+
+	template<typename T> bool enqueue_send_msg(T&& msg, bool prior) {return prior ? send_buffer.enqueue_front(std::forward<T>(msg)) : send_buffer.enqueue(std::forward<T>(msg));}
+	template<typename T> bool enqueue_send_msg(T&& msg, const lane& l) {return send_buffer.enqueue(std::forward<T>(msg), l);}
+	void move_send_msgs_in(in_container_type& msg_can, size_t size_in_byte, bool prior)
+		{prior ? send_buffer.move_items_in_front(msg_can, size_in_byte) : send_buffer.move_items_in(msg_can, size_in_byte);}
+	void move_send_msgs_in(in_container_type& msg_can, size_t size_in_byte, const lane& l) {send_buffer.move_items_in(msg_can, l, size_in_byte);}
+
+#ifdef ASCS_SYNC_RECV_CHANNEL
+	bool is_recv_admitted() const
+		{return (nullptr == inbox_ || inbox_->is_available(_id)) && !mem_paused && (nullptr == mem_gov || !mem_gov->is_rejecting()) && !sr_channel.full();}
+#else
+	bool is_recv_admitted() const {return (nullptr == inbox_ || inbox_->is_available(_id)) && !mem_paused && (nullptr == mem_gov || !mem_gov->is_rejecting());}
+#endif
+
+	//msgs in the receiving buffer and in dispatch partitions (see dispatch_by_key)
+#ifdef ASCS_DISPATCH_BATCH_MSG
+	size_t recv_size_in_byte() const {return recv_buffer.size_in_byte();}
+#else
+	size_t recv_size_in_byte() const {return recv_buffer.size_in_byte() + partition_bytes.load(std::memory_order_relaxed);}
+#endif
+
+	//after del_consumer returned, the governor has finished calling this socket (if it was) and will not call it any more.
+	void attach_mem_governor(bool attach)
+	{
+		if (nullptr == mem_gov)
+			return;
+		else if (!attach)
+			mem_gov->del_consumer(this);
+		else
+		{
+			mem_paused = false; //the governor may have recovered while this socket was not attached
+			mem_gov->add_consumer(this);
+		}
+	}
+
+	//i_memory_consumer, called by the memory governor (only if this socket is started, see mem_governor)
+	virtual uint_fast64_t mem_consumer_id() const {return _id;}
+	virtual size_t send_mem_usage() const {return send_buffer.size_in_byte();}
+	virtual size_t recv_mem_usage() const {return recv_size_in_byte();}
+	virtual size_t shed_send_msgs()
+	{
+		in_container_type msg_can;
+		pop_all_pending_send_msg(msg_can);
+		auto size = ascs::get_size_in_byte(msg_can);
+		update_mem_usage();
+		on_msg_shed(msg_can);
+
+		return size;
+	}
+	virtual void pause_recv_by_governor(bool pause) {mem_paused = pause; if (!pause) resume_recv();}
+#ifdef ASCS_MSG_DEADLINE
+	template<typename T> bool enqueue_send_msg(T&& msg, const deadline& d)
+		{in_msg item(std::forward<T>(msg)); item.expire_time = d.time; return enqueue_send_msg(std::move(item), d.prior);}
+	void move_send_msgs_in(in_container_type& msg_can, size_t size_in_byte, const deadline& d)
+	{
+		ascs::do_something_to_all(msg_can, [](in_msg& item) {item.follow_prev();});
+		if (!msg_can.empty())
+			msg_can.front().expire_time = d.time;
+		move_send_msgs_in(msg_can, size_in_byte, d.prior);
+	}
+#endif
+#ifdef ASCS_SYNC_SEND
+	template<typename T> bool enqueue_send_msg(T&& msg, const completion& c) {in_msg item(std::forward<T>(msg)); item.p = c.p; return enqueue_send_msg(std::move(item), c.prior);}
+	void move_send_msgs_in(in_container_type& msg_can, size_t size_in_byte, const completion& c)
+	{
+		if (!msg_can.empty())
+			msg_can.back().p = c.p; //the last item completes the whole msg
+		move_send_msgs_in(msg_can, size_in_byte, c.prior);
+	}
+#endif
+
+#ifdef ASCS_COROUTINE
+	//resume the coroutine which is awaiting co_send_msg in the dispatcher after the msg been sent or failed, if the msg was dropped without
+	// completion (an empty msg, or the socket is being destroyed for example), resume it with NOT_APPLICABLE in the io_context directly.
+	class co_send_completion : public i_send_completion
+	{
+	public:
+		co_send_completion(socket& owner_, const co_resumer<sync_call_result>& resumer_) : owner(owner_), io_context_(owner_.dis_strand.context()), resumer(resumer_), done(false) {}
+		~co_send_completion() {if (!done) {*resumer.result = sync_call_result::NOT_APPLICABLE; asio::post(io_context_, resumer);}}
+
+		virtual void complete(sync_call_result re) {if (!done) {done = true; *resumer.result = re; owner.post_resume(resumer);}}
+
+	private:
+		socket& owner;
+		asio::io_context& io_context_;
+		co_resumer<sync_call_result> resumer;
+		bool done;
+	};
+
+	//a coroutine which is awaiting co_safe_send_msg for the sending buffer, retry will be posted to the dispatcher by notify_send_buffer_waiters,
+	// if this socket is destroyed before that, resumer will be posted to the io_context with NOT_APPLICABLE (see ~socket).
+	struct co_sb_waiter
+	{
+		std::function<void()> retry;
+		co_resumer<sync_call_result> resumer;
+	};
+
+	//return false if the coroutine needn't to be suspended (the result has been put), otherwise, the coroutine will be resumed later.
+	template<typename Sender> bool co_safe_send(const std::shared_ptr<Sender>& sender, const co_resumer<sync_call_result>& resumer)
+	{
+		while (is_ready())
+		{
+			if (is_send_buffer_available())
+			{
+				auto c = make_send_completion<co_send_completion>(*this, resumer);
+				if (!(*sender)(completion(c)))
+					c->complete(sync_call_result::NOT_APPLICABLE);
+
+				return true;
+			}
+
+			std::lock_guard<std::mutex> lock(sb_mutex);
+			++sb_waiter_num;
+			std::atomic_thread_fence(std::memory_order_seq_cst); //either we see the room or notify_send_buffer_waiters sees sb_waiter_num
+			if (is_ready() && !is_send_buffer_available())
+			{
+				co_sb_waiters.emplace_back(co_sb_waiter {[this, sender, resumer]() {if (!this->co_safe_send(sender, resumer)) resumer();}, resumer});
+				return true;
+			}
+			--sb_waiter_num;
+		}
+
+		*resumer.result = sync_call_result::NOT_APPLICABLE;
+		return false;
+	}
+
+	//called in the dispatcher, return true if the coroutine will be resumed by the dispatcher later (see do_dispatch_msg).
+	bool co_recv_msg(const co_resumer<std::list<OutMsgType>>& resumer)
+	{
+		if (!co_recv_ready())
+		{
+			co_recv_waiter = resumer;
+			return true;
+		}
+
+		co_take_msgs(*resumer.result);
+		return false;
+	}
+
+#ifdef ASCS_DISPATCH_BATCH_MSG
+	bool co_recv_ready() const {return !recv_buffer.empty() || !started_;}
+#else
+	bool co_recv_ready() const {return dispatching || !recv_buffer.empty() || !started_;}
+#endif
+	void co_take_msgs(std::list<OutMsgType>& msg_can)
+	{
+		auto now = statistic::now();
+#ifndef ASCS_DISPATCH_BATCH_MSG
+		if (dispatching) //dispatching failed before the first async_recv_batch invocation
+		{
+			stat.dispatch_delay_sum += now - dispatching_msg.begin_time;
+			msg_can.emplace_back(std::move(dispatching_msg));
+			dispatching_msg.clear();
+			dispatching = false;
+		}
+#endif
+		out_container_type temp_buffer;
+		recv_buffer.move_items_out(temp_buffer);
+		ascs::do_something_to_all(temp_buffer, [&, this](out_msg& msg) {this->stat.dispatch_delay_sum += now - msg.begin_time; msg_can.emplace_back(std::move(msg));});
+
+		update_mem_usage();
+#ifndef ASCS_BACKPRESSURE_POLLING
+		check_resuming_recv();
+#endif
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+		grant_credit();
+#endif
+	}
+#endif
 
 #ifdef ASCS_SYNC_RECV
+#ifdef ASCS_SYNC_RECV_CHANNEL
+	//drain all batches in the channel, spin ASCS_SYNC_RECV_SPIN times before blocking if the channel is empty.
+	sync_call_result sync_recv_draining(std::list<OutMsgType>& msg_can, unsigned duration)
+	{
+		for (auto i = 0; !sr_channel_drained(msg_can); ++i)
+			if (!started_)
+				return sync_call_result::NOT_APPLICABLE;
+			else if (i >= ASCS_SYNC_RECV_SPIN)
+			{
+				std::unique_lock<std::mutex> lock(sync_recv_mutex);
+				sr_waiting.store(true, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst); //either we see the batch or handle_msg sees sr_waiting
+				auto pred = [this]() {return !this->started_ || !this->sr_channel.empty();};
+				if (0 == duration)
+					sync_recv_cv.wait(lock, std::move(pred));
+				else
+					sync_recv_cv.wait_for(lock, std::chrono::milliseconds(duration), std::move(pred));
+				sr_waiting.store(false, std::memory_order_relaxed);
+				lock.unlock();
+
+				if (sr_channel_drained(msg_can))
+					break;
+
+				return started_ ? sync_call_result::TIMEOUT : sync_call_result::NOT_APPLICABLE;
+			}
+
+		return sync_call_result::SUCCESS;
+	}
+
+	bool sr_channel_drained(std::list<OutMsgType>& msg_can)
+	{
+		if (0 == sr_channel.pop_all(msg_can))
+			return false;
+
+#ifndef ASCS_BACKPRESSURE_POLLING
+		check_resuming_recv(); //message receiving may have been suspended because of the channel been full
+#endif
+		return true;
+	}
+#else
 	sync_call_result sync_recv_waiting(std::unique_lock<std::mutex>& lock, unsigned duration)
 	{
 		auto pred = [this]() {return !this->started_ || sync_recv_status::REQUESTED != this->sr_status;};
@@ -584,6 +1335,7 @@ private:
 
 		return sync_recv_status::RESPONDED == sr_status ? sync_call_result::SUCCESS : sync_call_result::NOT_APPLICABLE;
 	}
+#endif
 #endif
 
 	bool check_receiving(bool raise_recv)
@@ -616,19 +1368,75 @@ private:
 		if (check_receiving(false))
 			return true;
 
+#ifdef ASCS_BACKPRESSURE_POLLING
 		set_timer(TIMER_CHECK_RECV, msg_resuming_interval_, [this](tid id)->bool {return !this->check_receiving(true);});
+#else
+		recv_suspended = true;
+		check_resuming_recv(); //the dispatcher may have drained the receiving buffer before recv_suspended been set
+#endif
 #endif
 		return false;
 	}
 
+#ifndef ASCS_BACKPRESSURE_POLLING
+	//called by the dispatcher after msg handling and by handled_msg, only the first caller resumes message receiving.
+	void check_resuming_recv()
+	{
+		if (recv_suspended && recv_buf_usage() <= recv_low_watermark_ && !ascs::is_full(recv_buffer, 0) && is_recv_admitted() && recv_suspended.exchange(false))
+			check_receiving(true);
+	}
+
+	//wait for resume_dispatch, which may have been called during on_msg_handle, then we retry immediately.
+	void hold_dispatching()
+	{
+		dispatch_held = true;
+		if (dispatch_resumed && dispatch_held.exchange(false))
+			post_dispatch_msg();
+	}
+#else
+	void hold_dispatching() {set_timer(TIMER_DISPATCH_MSG, msg_handling_interval_, [this](tid id)->bool {return this->timer_handler(TIMER_DISPATCH_MSG);});}
+#endif
+
 	//do not use dispatch_strand at here, because the handler (do_dispatch_msg) may call this function, which can lead stack overflow.
-	void dispatch_msg() {if (!dispatching) post_strand(dis_strand, [this]() {this->do_dispatch_msg();});}
+	void dispatch_msg() {if (!dispatching) post_dispatch_msg();}
+	void post_dispatch_msg()
+	{
+		if (nullptr == dis_executor)
+			post_strand(dis_strand, [this]() {this->do_dispatch_msg();});
+		else //socket id as the key, so all msgs of this socket will be dispatched by the same worker
+			dis_executor->post(_id, make_handler([this]() {this->do_dispatch_msg();}));
+	}
 	void do_dispatch_msg()
 	{
+#ifdef ASCS_COROUTINE
+		if (co_receiving)
+		{
+			if (co_recv_waiter.handle && co_recv_ready())
+			{
+				auto resumer = co_recv_waiter;
+				co_recv_waiter.handle = nullptr;
+				co_take_msgs(*resumer.result);
+				resumer(); //we're in the dispatcher already
+			}
+
+			return;
+		}
+#endif
+#ifndef ASCS_DISPATCH_BATCH_MSG
+		if (!partitions.empty())
+		{
+			do_dispatch_msg_by_key();
+			return;
+		}
+#endif
 #ifdef ASCS_DISPATCH_BATCH_MSG
 		if (!recv_buffer.empty())
 		{
 			dispatching = true;
+#ifndef ASCS_BACKPRESSURE_POLLING
+			if (dispatch_resumed.load(std::memory_order_relaxed))
+				dispatch_resumed.store(false, std::memory_order_relaxed);
+#endif
 			auto begin_time = statistic::now();
 #ifdef ASCS_FULL_STATISTIC
 			recv_buffer.do_something_to_all([&, this](out_msg& msg) {this->stat.dispatch_delay_sum += begin_time - msg.begin_time;});
@@ -642,7 +1450,7 @@ private:
 #ifdef ASCS_FULL_STATISTIC
 				recv_buffer.do_something_to_all([&end_time](out_msg& msg) {msg.restart(end_time);});
 #endif
-				set_timer(TIMER_DISPATCH_MSG, msg_handling_interval_, [this](tid id)->bool {return this->timer_handler(TIMER_DISPATCH_MSG);}); //hold dispatching
+				hold_dispatching();
 			}
 			else
 			{
@@ -650,6 +1458,10 @@ private:
 		if (dispatching || recv_buffer.try_dequeue(dispatching_msg))
 		{
 			dispatching = true;
+#ifndef ASCS_BACKPRESSURE_POLLING
+			if (dispatch_resumed.load(std::memory_order_relaxed))
+				dispatch_resumed.store(false, std::memory_order_relaxed);
+#endif
 			auto begin_time = statistic::now();
 			stat.dispatch_delay_sum += begin_time - dispatching_msg.begin_time;
 			auto re = on_msg_handle(dispatching_msg); //must before next msg dispatching to keep sequence
@@ -659,13 +1471,20 @@ private:
 			if (!re) //dispatch failed, re-dispatch
 			{
 				dispatching_msg.restart(end_time);
-				set_timer(TIMER_DISPATCH_MSG, msg_handling_interval_, [this](tid id)->bool {return this->timer_handler(TIMER_DISPATCH_MSG);}); //hold dispatching
+				hold_dispatching();
 			}
 			else
 			{
 				dispatching_msg.clear();
 #endif
 				dispatching = false;
+				update_mem_usage();
+#ifndef ASCS_BACKPRESSURE_POLLING
+				check_resuming_recv();
+#endif
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+				grant_credit();
+#endif
 				dispatch_msg(); //dispatch msg in sequence
 			}
 		}
@@ -673,12 +1492,183 @@ private:
 			dispatching = false;
 	}
 
+#ifndef ASCS_DISPATCH_BATCH_MSG
+	//msgs of a partition, the partition is dispatched by at most one handler at any time (scheduled), which keeps the order of msgs in it.
+	struct dispatch_partition
+	{
+		dispatch_partition(size_t index_) : index(index_) {clear();}
+		void clear() {msgs.clear(); size_in_byte = 0; scheduled = held = feeder_waiting = false;}
+
+		size_t index;
+		std::mutex mutex;
+		std::list<out_msg> msgs;
+		size_t size_in_byte;
+		bool scheduled; //a handler has been posted for this partition, or this partition is held (see below)
+		bool held; //on_msg_handle failed, wait for the feeder (do_dispatch_msg_by_key) to retry
+		bool feeder_waiting; //the feeder is waiting for this partition to be drained
+		//partition handlers run concurrently, so they cannot access stat directly, the feeder collects these durations
+		statistic::stat_duration dispatch_delay_sum, handle_time_sum;
+	};
+
+	void post_partition(dispatch_partition& p)
+	{
+		if (nullptr == dis_executor)
+			post([this, &p]() {this->do_dispatch_partition(p);});
+		else
+			dis_executor->post(partition_key(p.index), make_handler([this, &p]() {this->do_dispatch_partition(p);}));
+	}
+
+	//the key which partitions post to the dispatch executor with, socket id is used by the feeder, and since socket ids are consecutive,
+	// _id + 1 + index would be the same as the keys of neighbour sockets (and their partitions), so mix them (splitmix64), then partitions
+	// spread over the executor's workers. collisions are still possible but harmless, they only serialize handlers, never reorder msgs of a key.
+	uint_fast64_t partition_key(size_t index) const
+	{
+		auto key = (uint_fast64_t) _id * 0x9e3779b97f4a7c15ULL + index + 1;
+		key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+		return key ^ (key >> 31);
+	}
+
+	//the feeder, it's still serialized by dis_strand or the dispatch executor (with socket id as the key), it moves msgs from the receiving
+	// buffer to partitions, and retries held partitions after resume_dispatch() been called (or after msg_handling_interval() milliseconds).
+	void do_dispatch_msg_by_key()
+	{
+#ifdef ASCS_BACKPRESSURE_POLLING
+		if (partition_held.load(std::memory_order_relaxed))
+			partition_held = false;
+#else
+		if (dispatch_resumed.load(std::memory_order_relaxed))
+			dispatch_resumed.store(false, std::memory_order_relaxed);
+#endif
+		for (auto& item : partitions)
+		{
+			std::unique_lock<std::mutex> lock(item->mutex);
+			stat.dispatch_delay_sum += item->dispatch_delay_sum;
+			stat.handle_time_sum += item->handle_time_sum;
+			item->dispatch_delay_sum = item->handle_time_sum = statistic::stat_duration();
+			if (item->held)
+			{
+				item->held = false;
+				lock.unlock();
+				post_partition(*item);
+			}
+		}
+
+		auto partition_buf_size = std::max(recv_buf_size_ / partitions.size(), (size_t) 1);
+		while (key_blocked || recv_buffer.try_dequeue(dispatching_msg))
+		{
+			auto& p = *partitions[extractor_(dispatching_msg) % partitions.size()];
+			std::unique_lock<std::mutex> lock(p.mutex);
+			if (!p.msgs.empty() && p.size_in_byte >= partition_buf_size)
+			{
+				key_blocked = p.feeder_waiting = true; //the partition will call dispatch_msg() after it's been drained
+				break;
+			}
+
+			key_blocked = false;
+			p.size_in_byte += dispatching_msg.size();
+			partition_bytes.fetch_add(dispatching_msg.size(), std::memory_order_relaxed); //before the partition can see it
+			p.msgs.emplace_back(std::move(dispatching_msg));
+			dispatching_msg.clear();
+			if (!p.scheduled)
+			{
+				p.scheduled = true;
+				lock.unlock();
+				post_partition(p);
+			}
+		}
+
+		update_mem_usage();
+#ifndef ASCS_BACKPRESSURE_POLLING
+		check_resuming_recv();
+#endif
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+		grant_credit();
+#endif
+	}
+
+	void do_dispatch_partition(dispatch_partition& p)
+	{
+		auto partition_buf_size = std::max(recv_buf_size_ / partitions.size(), (size_t) 1);
+		size_t handled_size = 0;
+		std::unique_lock<std::mutex> lock(p.mutex);
+		//only handle msgs which already exist, then other partitions (of other sockets) in the same thread will not be starved.
+		for (auto n = p.msgs.size(); n > 0; --n)
+		{
+			auto& msg = p.msgs.front(); //the feeder only appends msgs, so msg keeps valid without the lock
+			lock.unlock();
+
+			auto begin_time = statistic::now();
+			auto re = on_msg_handle(msg);
+			auto end_time = statistic::now();
+
+			lock.lock();
+			p.dispatch_delay_sum += begin_time - msg.begin_time;
+			p.handle_time_sum += end_time - begin_time;
+			if (!re) //dispatch failed, hold this partition until the feeder retries it
+			{
+				msg.restart(end_time);
+				p.held = true;
+				lock.unlock();
+				release_partition_bytes(handled_size);
+#ifdef ASCS_BACKPRESSURE_POLLING
+				if (partition_held.exchange(true)) //partitions fail concurrently, but the timer can only be set in one thread at a time
+					return;
+#endif
+				hold_dispatching();
+				return;
+			}
+
+			p.size_in_byte -= msg.size();
+			handled_size += msg.size();
+			p.msgs.pop_front();
+			if (p.feeder_waiting && p.size_in_byte < partition_buf_size)
+			{
+				p.feeder_waiting = false;
+				lock.unlock();
+				dispatch_msg();
+				lock.lock();
+			}
+		}
+
+		if (p.msgs.empty())
+		{
+			p.scheduled = false;
+			lock.unlock();
+		}
+		else
+		{
+			lock.unlock();
+			post_partition(p);
+		}
+
+		release_partition_bytes(handled_size);
+	}
+
+	//partitions release their budget once per run rather than per msg, then resume message receiving (and grant credits) if the receiving
+	// buffer is empty and only partitions held the budget, in which case the feeder will not run again to do so.
+	void release_partition_bytes(size_t size)
+	{
+		if (0 == size)
+			return;
+
+		partition_bytes.fetch_sub(size, std::memory_order_relaxed);
+		update_mem_usage();
+#ifndef ASCS_BACKPRESSURE_POLLING
+		check_resuming_recv();
+#endif
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+		grant_credit();
+#endif
+	}
+#endif
+
 	bool timer_handler(tid id)
 	{
 		switch (id)
 		{
 		case TIMER_DISPATCH_MSG:
-			post_strand(dis_strand, [this]() {this->do_dispatch_msg();});
+			post_dispatch_msg();
 			break;
 		case TIMER_DELAY_CLOSE:
 			if (!is_last_async_call())
@@ -696,6 +1686,11 @@ private:
 			change_timer_status(TIMER_DELAY_CLOSE, timer_info::TIMER_CANCELED);
 			after_close();
 			set_async_calling(false);
+			if (!started_) //not restarted (reconnecting for example)
+				complete_pending_send_msgs();
+			closing = false;
+			if (nullptr != pool_)
+				pool_->on_obsoleted(_id);
 			break;
 		default:
 			assert(false);
@@ -711,6 +1706,10 @@ protected:
 
 	in_queue_type send_buffer;
 	volatile bool sending;
+	std::atomic_bool send_scheduled; //the doorbell, do_send_msg has been scheduled by send_msg but has not run yet
+#ifdef ASCS_SEND_CORK_DELAY
+	std::atomic_bool corked; //implies sending
+#endif
 
 #ifdef ASCS_PASSIVE_RECV
 	volatile bool reading;
@@ -722,7 +1721,20 @@ private:
 	std::shared_ptr<i_unpacker<typename Unpacker::msg_type>> unpacker_;
 
 	bool recv_idle_began;
+#ifdef ASCS_MSG_DEADLINE
+	bool expiring; //the last checked item (except followers) expired, see is_expired
+#endif
+#ifdef ASCS_COROUTINE
+	std::atomic_bool co_receiving; //msgs are received by async_recv_batch rather than on_msg_handle
+	co_resumer<std::list<OutMsgType>> co_recv_waiter; //the coroutine which is awaiting async_recv_batch, only accessed in the dispatcher
+#endif
+#ifndef ASCS_BACKPRESSURE_POLLING
+	std::atomic_bool recv_suspended; //message receiving is suspended because of the receiving buffer been overflow
+	std::atomic_bool dispatch_held, dispatch_resumed; //see hold_dispatching and resume_dispatch
+	float recv_low_watermark_;
+#endif
 	volatile bool started_; //has started or not
+	std::atomic_bool closing; //see is_closing
 	volatile bool dispatching;
 #ifndef ASCS_DISPATCH_BATCH_MSG
 	out_msg dispatching_msg;
@@ -730,21 +1742,53 @@ private:
 
 	typename statistic::stat_time recv_idle_begin_time;
 	out_queue_type recv_buffer;
+	out_container_type recv_backlog; //msgs which cannot be held by a bounded receiving buffer (like spsc_queue), only accessed in rw_strand
 
 	uint_fast64_t _id;
+	i_object_pool* pool_; //who created this socket, null if this socket is not managed by object_pool
 	Socket next_layer_;
 
 	std::atomic_flag start_atomic;
 	asio::io_context::strand dis_strand;
+	i_dispatch_executor* dis_executor; //dispatch msgs in it rather than dis_strand if not null
+	i_inbox<OutMsgType>* inbox_; //push msgs into it rather than recv_buffer if not null
+	memory_governor* mem_gov; //charge buffers against it if not null
+	std::atomic_size_t mem_charged; //the usage which has been charged to mem_gov
+	std::atomic_bool mem_paused; //message receiving is paused by mem_gov
+#ifndef ASCS_DISPATCH_BATCH_MSG
+	key_extractor extractor_;
+	std::vector<std::unique_ptr<dispatch_partition>> partitions;
+	bool key_blocked; //dispatching_msg is waiting for its partition to be drained, only accessed by the feeder
+	std::atomic_size_t partition_bytes; //msgs in all partitions, added by the feeder and subtracted by partitions
+#ifdef ASCS_BACKPRESSURE_POLLING
+	std::atomic_bool partition_held; //the retrying timer has been set by a held partition
+#endif
+#endif
 
 #ifdef ASCS_SYNC_RECV
+#ifdef ASCS_SYNC_RECV_CHANNEL
+	spsc_channel<OutMsgType, ASCS_SYNC_RECV_CHANNEL> sr_channel;
+	std::atomic_bool sr_channel_open; //sync_recv_msg has been invoked, so all msgs go to sr_channel
+	std::atomic_bool sr_consuming; //sync_recv_msg is running
+	std::atomic_bool sr_waiting; //sync_recv_msg is blocking (or going to block) on sync_recv_cv
+#else
 	enum sync_recv_status {NOT_REQUESTED, REQUESTED, RESPONDED, RESPONDED_FAILURE};
 	sync_recv_status sr_status;
+#endif
 
 	std::mutex sync_recv_mutex;
 	std::condition_variable sync_recv_cv;
 #endif
 
+	bool send_buf_high; //on_send_buffer_high has been invoked and on_send_buffer_low has not, only accessed in rw_strand
+	float send_high_watermark_, send_low_watermark_;
+	std::atomic_size_t sb_waiter_num; //how many threads (and coroutines) are blocking (or going to block) in wait_send_buffer_available (and co_safe_send)
+	std::mutex sb_mutex;
+	std::condition_variable sb_cv;
+#ifdef ASCS_COROUTINE
+	std::list<co_sb_waiter> co_sb_waiters; //protected by sb_mutex
+#endif
+
 	size_t send_buf_size_, recv_buf_size_;
 	unsigned msg_resuming_interval_, msg_handling_interval_;
 };
@@ -71,6 +71,11 @@ public:
 	//success at here just means put the msg into tcp::socket_base's send buffer
 	TCP_BROADCAST_MSG(safe_broadcast_msg, safe_send_msg)
 	TCP_BROADCAST_MSG(safe_broadcast_native_msg, safe_send_native_msg)
+	//pack only once, all sockets share the packed message, see macro TCP_SHARED_BROADCAST_MSG for more details
+	TCP_SHARED_BROADCAST_MSG(shared_broadcast_msg, false)
+	TCP_SHARED_BROADCAST_MSG(shared_broadcast_native_msg, true)
+	TCP_PARALLEL_BROADCAST_MSG(parallel_broadcast_msg, false)
+	TCP_PARALLEL_BROADCAST_MSG(parallel_broadcast_native_msg, true)
 	//msg sending interface
 	///////////////////////////////////////////////////
 
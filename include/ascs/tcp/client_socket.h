@@ -85,6 +85,10 @@ public:
 	void force_shutdown(bool reconnect = false)
 	{
 		need_reconnect = reconnect;
+#ifdef ASCS_COROUTINE
+		if (!reconnect)
+			co_resume_connect(false);
+#endif
 
 		if (reconnect && this->is_broken() && !this->started())
 			return this->start();
@@ -112,9 +116,45 @@ public:
 		super::graceful_shutdown(sync);
 	}
 
+#ifdef ASCS_COROUTINE
+	//co_await async_connect() returns true after the connection been established (immediately if it's already established), or false if
+	// reconnecting has been abandoned or this socket has been shut down without reconnecting, start this socket if it hasn't been started,
+	// the coroutine is resumed in the dispatcher (see ascs::socket::async_recv_batch), only one coroutine can await it at the same time.
+	auto async_connect()
+	{
+		return make_co_awaitable<bool>([this](const co_resumer<bool>& resumer) {
+			{
+				std::lock_guard<std::mutex> lock(co_connect_mutex);
+				if (this->is_connected())
+				{
+					*resumer.result = true;
+					return false;
+				}
+				co_connect_waiter = resumer;
+			}
+
+			if (!this->started())
+			{
+				this->start();
+				if (!this->started())
+					this->co_resume_connect(false);
+			}
+
+			return true;
+		});
+	}
+#endif
+
 protected:
 	//helper function, just call it in constructor
-	void first_init(Matrix* matrix_ = nullptr) {need_reconnect = ASCS_RECONNECT; matrix = matrix_;}
+	void first_init(Matrix* matrix_ = nullptr)
+	{
+		need_reconnect = ASCS_RECONNECT;
+		matrix = matrix_;
+#ifdef ASCS_COROUTINE
+		co_connect_waiter.handle = nullptr;
+#endif
+	}
 
 	Matrix* get_matrix() {return matrix;}
 	const Matrix* get_matrix() const {return matrix;}
@@ -128,7 +168,12 @@ protected:
 	virtual void connect_handler(const asio::error_code& ec)
 	{
 		if (!ec) //already started, so cannot call start()
+		{
 			super::do_start();
+#ifdef ASCS_COROUTINE
+			co_resume_connect(true);
+#endif
+		}
 		else
 			prepare_next_reconnect(ec);
 	}
@@ -197,14 +242,37 @@ private:
 
 		unified_out::info_out(ASCS_LLF " reconnectiong abandon.", this->id());
 		super::force_shutdown();
+#ifdef ASCS_COROUTINE
+		co_resume_connect(false);
+#endif
 		return false;
 	}
 
+#ifdef ASCS_COROUTINE
+	void co_resume_connect(bool re)
+	{
+		std::unique_lock<std::mutex> lock(co_connect_mutex);
+		if (co_connect_waiter.handle)
+		{
+			auto resumer = co_connect_waiter;
+			co_connect_waiter.handle = nullptr;
+			lock.unlock();
+
+			*resumer.result = re;
+			this->post_resume(resumer);
+		}
+	}
+#endif
+
 private:
 	bool need_reconnect;
 	typename Family::endpoint server_addr;
 
 	Matrix* matrix;
+#ifdef ASCS_COROUTINE
+	co_resumer<bool> co_connect_waiter; //the coroutine which is awaiting async_connect
+	std::mutex co_connect_mutex;
+#endif
 };
 
 template <typename Packer, typename Unpacker, typename Matrix = i_matrix, typename Socket = asio::ip::tcp::socket,
@@ -33,18 +33,36 @@ private:
 protected:
 	enum link_status {CONNECTED, FORCE_SHUTTING_DOWN, GRACEFUL_SHUTTING_DOWN, BROKEN, HANDSHAKING};
 
-	socket_base(asio::io_context& io_context_) : super(io_context_), status(link_status::BROKEN) {}
-	template<typename Arg> socket_base(asio::io_context& io_context_, Arg&& arg) : super(io_context_, std::forward<Arg>(arg)), status(link_status::BROKEN) {}
+	socket_base(asio::io_context& io_context_) : super(io_context_), status(link_status::BROKEN), sending_msg_num(0), cork_released(false) {first_init();}
+	template<typename Arg> socket_base(asio::io_context& io_context_, Arg&& arg) :
+		super(io_context_, std::forward<Arg>(arg)), status(link_status::BROKEN), sending_msg_num(0), cork_released(false) {first_init();}
+
+	//helper function, just call it in constructor
+	void first_init()
+	{
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+		credit_enabled = false;
+		reset_credit();
+#endif
+	}
 
 public:
 	static const typename super::tid TIMER_BEGIN = super::TIMER_END;
 	static const typename super::tid TIMER_ASYNC_SHUTDOWN = TIMER_BEGIN;
+	static const typename super::tid TIMER_SEND_CORK = TIMER_BEGIN + 1;
 	static const typename super::tid TIMER_END = TIMER_BEGIN + 5;
 
 	virtual bool obsoleted() {return !is_shutting_down() && super::obsoleted();}
 	virtual bool is_ready() {return is_connected();}
 	virtual void send_heartbeat()
 	{
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+		if (credit_enabled) //credit frames replace heartbeats
+		{
+			this->dispatch_strand(rw_strand, [this]() {this->credit_heartbeat = true; if (!this->sending) this->do_send_msg(true);});
+			return;
+		}
+#endif
 		auto_duration dur(stat.pack_time_sum);
 		auto msg = this->packer()->pack_heartbeat();
 		dur.end();
@@ -56,7 +74,11 @@ public:
 	//notice, when reusing this socket, object_pool will invoke this function, so if you want to do some additional initialization
 	// for this socket, do it at here and in the constructor.
 	//for tcp::single_client_base and ssl::single_client_base, this virtual function will never be called, please note.
-	virtual void reset() {status = link_status::BROKEN; sending_msgs.clear(); super::reset();}
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	virtual void reset() {status = link_status::BROKEN; ascs::complete_dropped_items(sending_msgs); sending_msgs.clear(); cork_released = false; reset_credit(); super::reset();}
+#else
+	virtual void reset() {status = link_status::BROKEN; ascs::complete_dropped_items(sending_msgs); sending_msgs.clear(); cork_released = false; super::reset();}
+#endif
 
 	//SOCKET status
 	link_status get_link_status() const {return status;}
@@ -64,6 +86,13 @@ public:
 	bool is_connected() const {return link_status::CONNECTED == status;}
 	bool is_shutting_down() const {return link_status::FORCE_SHUTTING_DOWN == status || link_status::GRACEFUL_SHUTTING_DOWN == status;}
 
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	//how many bytes we can send before the peer grants new credits, negative value means we've exceeded the credits (one msg can exceed them),
+	// it's not thread safe (only for monitoring, it's accurate in rw_strand), always 0 if credit flow control is disabled.
+	int_fast64_t send_credit() const {return credit_enabled ? (int_fast64_t) (peer_edge - sent_edge) : 0;}
+	bool is_credit_enabled() const {return credit_enabled;}
+#endif
+
 	std::string endpoint_to_string(const asio::ip::tcp::endpoint& ep) const {return ep.address().to_string() + ':' + std::to_string(ep.port());}
 #ifdef ASIO_HAS_LOCAL_SOCKETS
 	std::string endpoint_to_string(const asio::local::stream_protocol::endpoint& ep) const {return ep.path();}
@@ -149,10 +178,14 @@ public:
 	// use it any more, use std::move to wrap it when calling direct_send_msg or direct_sync_send_msg.
 	TCP_SEND_MSG(send_msg, false) //use the packer with native = false to pack the msgs
 	TCP_SEND_MSG(send_native_msg, true) //use the packer with native = true to pack the msgs
+	ASCS_CO_SEND_MSG(async_send, send_msg) //co_await async_send(msg), see macro ASCS_COROUTINE
+	ASCS_CO_SEND_MSG(async_send_native, send_native_msg)
 	//guarantee send msg successfully even if can_overflow equal to false
 	//success at here just means put the msg into tcp::socket_base's send buffer
 	TCP_SAFE_SEND_MSG(safe_send_msg, send_msg)
 	TCP_SAFE_SEND_MSG(safe_send_native_msg, send_native_msg)
+	ASCS_CO_SAFE_SEND_MSG(async_safe_send, send_msg) //co_await async_safe_send(msg), see macro ASCS_COROUTINE
+	ASCS_CO_SAFE_SEND_MSG(async_safe_send_native, send_native_msg)
 
 #ifdef ASCS_SYNC_SEND
 	TCP_SYNC_SEND_MSG(sync_send_msg, false) //use the packer with native = false to pack the msgs
@@ -202,6 +235,17 @@ protected:
 	{
 		status = link_status::CONNECTED;
 		stat.establish_time = time(nullptr);
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+		reset_credit(); //for reconnecting without reset()
+		credit_enabled = !this->packer()->pack_credit(0).empty() && this->unpacker()->supports_credit();
+		if (credit_enabled)
+		{
+			//credit frames are tiny writes, nagle's algorithm plus the peer's delayed ack would hold them for tens of milliseconds
+			asio::error_code ec;
+			this->lowest_layer().set_option(asio::ip::tcp::no_delay(true), ec); //ignore errors (unix domain socket for example)
+			granted_edge = this->recv_buf_size(); //the initial window, it will be sent by super::do_start
+		}
+#endif
 
 		on_connect(); //in this virtual function, stat.last_recv_time has not been updated (super::do_start will update it), please note
 		return super::do_start();
@@ -233,7 +277,7 @@ protected:
 	virtual void on_close()
 	{
 #ifdef ASCS_SYNC_SEND
-		ascs::do_something_to_all(sending_msgs, [](typename super::in_msg& msg) {if (msg.p) msg.p->set_value(sync_call_result::NOT_APPLICABLE);});
+		ascs::do_something_to_all(sending_msgs, [](typename super::in_msg& msg) {msg.complete(sync_call_result::NOT_APPLICABLE);});
 #endif
 		status = link_status::BROKEN;
 		super::on_close();
@@ -305,6 +349,10 @@ private:
 			auto_duration dur(stat.unpack_time_sum);
 			auto unpack_ok = this->unpacker()->parse_msg(bytes_transferred, temp_msg_can);
 			dur.end();
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+			if (credit_enabled)
+				update_credit(bytes_transferred); //before resetting the unpacker
+#endif
 
 			if (!unpack_ok)
 			{
@@ -315,6 +363,9 @@ private:
 			}
 
 			need_next_recv = handle_msg(); //if macro ASCS_PASSIVE_RECV been defined, handle_msg will always return false
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+			grant_credit(); //credit frames and heartbeats also consume credits, but they will never be dispatched
+#endif
 		}
 		else if (!ec)
 		{
@@ -337,23 +388,74 @@ private:
 	{
 		if (!in_strand && sending)
 			return true;
+#ifdef ASCS_SEND_CORK_DELAY
+		else if (!in_strand && cork())
+			return true;
+#endif
 
 		auto end_time = statistic::now();
-#ifdef ASCS_WANT_MSG_SEND_NOTIFY
-		send_buffer.move_items_out(0, sending_msgs);
-#else
-		send_buffer.move_items_out(asio::detail::default_max_transfer_size, sending_msgs);
+		move_sending_msgs_out(end_time);
+#ifdef ASCS_MSG_DEADLINE
+		while (this->drop_expired_msgs(sending_msgs) && sending_msgs.empty() && !send_buffer.empty()) //all msgs expired, try subsequent ones
+			move_sending_msgs_out(end_time);
 #endif
+		this->update_mem_usage();
 		sending_buffer.clear(); //this buffer will not be refreshed according to sending_msgs timely
-		ascs::do_something_to_all(sending_msgs, [this, &end_time](typename super::in_msg& item) {
+		staging_block.clear();
+		staged_buffers.clear();
+		sending_msg_num = 0;
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+		if (credit_enabled && (granted_edge.load(std::memory_order_relaxed) > announced_edge || credit_heartbeat)) //credit frame goes first
+		{
+			announced_edge = granted_edge.load(std::memory_order_relaxed);
+			credit_heartbeat = false;
+			credit_msg = this->packer()->pack_credit(announced_edge);
+			sending_buffer.emplace_back(credit_msg.data(), credit_msg.size());
+		}
+#endif
+		auto last_staged = false;
+		ascs::do_something_to_all(sending_msgs, [&, this](typename super::in_msg& item) {
+			++this->sending_msg_num;
 			this->stat.send_delay_sum += end_time - item.begin_time;
-			this->sending_buffer.emplace_back(item.data(), item.size());
+			//small msgs and all msgs after the gather list almost reached ASCS_MAX_IOV_NUM go to the staging block, adjacent ones share one buffer
+			if (item.size() < ASCS_SEND_COALESCE_SIZE || this->sending_buffer.size() >= ASCS_MAX_IOV_NUM - 1)
+			{
+				if (!last_staged)
+				{
+					this->staged_buffers.push_back(std::make_pair(this->sending_buffer.size(), this->staging_block.size()));
+					this->sending_buffer.emplace_back(nullptr, 0);
+					last_staged = true;
+				}
+				this->sending_buffer.back() = asio::const_buffer(nullptr, this->sending_buffer.back().size() + item.size());
+				this->staging_block.append(item.data(), item.size());
+			}
+			else
+			{
+				this->sending_buffer.emplace_back(item.data(), item.size());
+				last_staged = false;
+			}
 		});
+		//the staging block will not be reallocated any more, so it's safe to refer to it now
+		for (auto& item : staged_buffers)
+			sending_buffer[item.first] = asio::const_buffer(staging_block.data() + item.second, sending_buffer[item.first].size());
+		stat.send_coalesced_byte_sum += staging_block.size();
+		if (cork_released)
+		{
+			if (sending_msg_num > 1)
+				stat.send_saved_write_sum += sending_msg_num - 1;
+			cork_released = false;
+		}
 
 		if (!sending_buffer.empty())
 		{
 			sending = true;
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+			sent_edge += asio::buffer_size(sending_buffer);
+			if (!sending_msgs.empty()) //not only a credit frame
+				sending_msgs.front().restart();
+#else
 			sending_msgs.front().restart();
+#endif
 			asio::async_write(this->next_layer(), sending_buffer, make_strand_handler(rw_strand,
 				this->make_handler_error_size([this](const asio::error_code& ec, size_t bytes_transferred) {this->send_handler(ec, bytes_transferred);})));
 			return true;
@@ -370,10 +472,21 @@ private:
 			stat.last_send_time = time(nullptr);
 
 			stat.send_byte_sum += bytes_transferred;
+			auto peak_usage = send_buffer.size_in_byte(); //msgs accumulated during this write
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+			if (0 == sending_msg_num) //only a credit frame has been sent
+			{
+				if (!do_send_msg(true) && !send_buffer.empty())
+					do_send_msg(true);
+				this->check_send_buffer(peak_usage);
+				return;
+			}
+#endif
 			stat.send_time_sum += statistic::now() - sending_msgs.front().begin_time;
-			stat.send_msg_sum += sending_buffer.size();
+			stat.send_msg_sum += sending_msg_num;
+			this->resume_dispatch(); //the sending buffer has more room now, on_msg_handle that failed because of it can succeed
 #ifdef ASCS_SYNC_SEND
-			ascs::do_something_to_all(sending_msgs, [](typename super::in_msg& item) {if (item.p) {item.p->set_value(sync_call_result::SUCCESS);}});
+			ascs::do_something_to_all(sending_msgs, [](typename super::in_msg& item) {item.complete(sync_call_result::SUCCESS);});
 #endif
 #ifdef ASCS_WANT_MSG_SEND_NOTIFY
 			this->on_msg_send(sending_msgs.front());
@@ -399,11 +512,12 @@ private:
 			sending_msgs.clear();
 			if (!do_send_msg(true) && !send_buffer.empty()) //send msg in sequence
 				do_send_msg(true); //just make sure no pending msgs
+			this->check_send_buffer(peak_usage);
 		}
 		else
 		{
 #ifdef ASCS_SYNC_SEND
-			ascs::do_something_to_all(sending_msgs, [](typename super::in_msg& item) {if (item.p) {item.p->set_value(sync_call_result::NOT_APPLICABLE);}});
+			ascs::do_something_to_all(sending_msgs, [](typename super::in_msg& item) {item.complete(sync_call_result::NOT_APPLICABLE);});
 #endif
 			on_send_error(ec, sending_msgs);
 			sending_msgs.clear(); //clear sending messages after on_send_error, then user can decide how to deal with them in on_send_error
@@ -412,6 +526,112 @@ private:
 		}
 	}
 
+	//must be called in rw_strand
+	void move_sending_msgs_out(typename statistic::stat_time now)
+	{
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+		if (credit_enabled)
+			move_credited_msgs_out(now);
+		else
+#endif
+#ifdef ASCS_WANT_MSG_SEND_NOTIFY
+		send_buffer.move_items_out(0, sending_msgs);
+#else
+		send_buffer.move_items_out(asio::detail::default_max_transfer_size, sending_msgs);
+#endif
+	}
+
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	void reset_credit()
+	{
+		peer_edge = sent_edge = announced_edge = 0;
+		recv_wire_bytes = granted_edge = 0;
+		credit_blocked = credit_heartbeat = false;
+	}
+
+	//must be called in rw_strand, take msgs from the sending buffer as far as the peer's credits allow (at least one msg if there're credits).
+	void move_credited_msgs_out(typename statistic::stat_time now)
+	{
+		auto credit = send_credit();
+		if (credit <= 0)
+		{
+			if (!credit_blocked && !send_buffer.empty())
+			{
+				credit_blocked = true;
+				credit_block_begin_time = now;
+			}
+			return;
+		}
+		else if (credit_blocked)
+		{
+			credit_blocked = false;
+			stat.send_credit_wait_sum += now - credit_block_begin_time;
+		}
+
+#ifdef ASCS_WANT_MSG_SEND_NOTIFY
+		send_buffer.move_items_out(0, sending_msgs);
+#else
+		send_buffer.move_items_out(std::min((size_t) credit, (size_t) asio::detail::default_max_transfer_size), sending_msgs);
+#endif
+	}
+
+	//must be called in rw_strand.
+	void update_credit(size_t bytes_transferred)
+	{
+		recv_wire_bytes.fetch_add(bytes_transferred, std::memory_order_relaxed);
+		auto edge = this->unpacker()->credit_edge();
+		if (edge > peer_edge)
+		{
+			peer_edge = edge;
+			if (credit_blocked && !sending)
+				do_send_msg(true);
+		}
+	}
+
+	//can be called in any thread (by the dispatcher or recv_handler), new credits are the free space of the receiving buffer.
+	virtual void grant_credit()
+	{
+		if (!credit_enabled)
+			return;
+
+		auto usage = this->recv_buf_usage();
+		auto edge = recv_wire_bytes.load(std::memory_order_relaxed) + (usage < 1.f ? (uint_fast64_t) ((1.f - usage) * this->recv_buf_size()) : 0);
+		auto threshold = (uint_fast64_t) (this->recv_buf_size() * ASCS_CREDIT_UPDATE_THRESHOLD);
+		auto granted = granted_edge.load(std::memory_order_relaxed);
+		while (edge >= granted + threshold)
+			if (granted_edge.compare_exchange_weak(granted, edge, std::memory_order_relaxed))
+			{
+				this->dispatch_strand(rw_strand, [this]() {if (!this->sending && this->is_ready()) this->do_send_msg(true);});
+				break;
+			}
+	}
+#endif
+
+#ifdef ASCS_SEND_CORK_DELAY
+	//hold the idle writer if there're only a few bytes to be sent, must be called in rw_strand, see macro ASCS_SEND_CORK_DELAY for more details.
+	bool cork()
+	{
+		if (send_buffer.empty() || send_buffer.size_in_byte() >= ASCS_SEND_CORK_SIZE)
+			return false;
+
+		corked = true;
+		sending = true;
+		this->set_timer(TIMER_SEND_CORK, ASCS_SEND_CORK_DELAY, [this](typename super::tid id)->bool {this->uncork(); return false;});
+		return true;
+	}
+
+	//can be called in any thread (by the timer or send_msg), only the first caller releases the cork.
+	virtual void uncork()
+	{
+		if (corked.exchange(false))
+			this->post_strand(rw_strand, [this]() {
+				cork_released = true;
+				if (!this->do_send_msg(true) && !send_buffer.empty()) //just make sure no pending msgs, like send_handler
+					this->do_send_msg(true);
+			});
+	}
+#endif
+
 	bool async_shutdown_handler(size_t loop_num)
 	{
 		if (link_status::GRACEFUL_SHUTTING_DOWN == status)
@@ -441,6 +661,9 @@ private:
 
 	using super::send_buffer;
 	using super::sending;
+#ifdef ASCS_SEND_CORK_DELAY
+	using super::corked;
+#endif
 
 #ifdef ASCS_PASSIVE_RECV
 	using super::reading;
@@ -448,7 +671,24 @@ private:
 	using super::rw_strand;
 
 	typename super::in_container_type sending_msgs;
+	size_t sending_msg_num; //the size of sending_msgs, sending_buffer no longer has one item per msg because of coalescing
 	std::vector<asio::const_buffer> sending_buffer; //just to reduce memory allocation and keep the size of sending items (linear complexity, it's very important).
+	std::string staging_block; //small msgs are copied into it, see macro ASCS_SEND_COALESCE_SIZE
+	std::vector<std::pair<size_t, size_t>> staged_buffers; //indexes in sending_buffer and offsets in staging_block of staged buffers
+	bool cork_released; //the next write is triggered by uncork, see macro ASCS_SEND_CORK_DELAY
+
+#ifdef ASCS_CREDIT_FLOW_CONTROL
+	//all edges are counted in bytes on the wire (since the connection been established), see macro ASCS_CREDIT_FLOW_CONTROL
+	bool credit_enabled; //both the packer and the unpacker support credit frames
+	uint_fast64_t peer_edge; //we can send at most so many bytes
+	uint_fast64_t sent_edge; //we've sent so many bytes
+	uint_fast64_t announced_edge; //the last credit edge we've sent to the peer
+	std::atomic<uint_fast64_t> recv_wire_bytes; //we've received so many bytes
+	std::atomic<uint_fast64_t> granted_edge; //the peer can send at most so many bytes, will be announced by the next write
+	bool credit_blocked, credit_heartbeat;
+	typename statistic::stat_time credit_block_begin_time;
+	in_msg_type credit_msg; //must keep valid until send_handler been called
+#endif
 };
 
 }} //namespace
@@ -161,11 +161,11 @@ private:
 	using super::shutdown_ssl;
 };
 
-template<typename Object>
-class object_pool : public ascs::object_pool<Object>
+template<typename Object, typename Container = object_map<Object>>
+class object_pool : public ascs::object_pool<Object, Container>
 {
 private:
-	typedef ascs::object_pool<Object> super;
+	typedef ascs::object_pool<Object, Container> super;
 
 public:
 	object_pool(service_pump& service_pump_, asio::ssl::context::method&& m) : super(service_pump_), ctx(std::forward<asio::ssl::context::method>(m)) {}
@@ -177,6 +177,9 @@ protected:
 private:
 	asio::ssl::context ctx;
 };
+template<typename Object> using sharded_object_pool = object_pool<Object, sharded_object_map<Object>>;
+template<typename Object> using slot_object_pool = object_pool<Object, slot_object_map<Object>>;
+template<typename Object> using snapshot_object_pool = object_pool<Object, snapshot_object_map<Object>>;
 
 template<typename Packer, typename Unpacker, typename Server = tcp::i_server, typename Socket = asio::ssl::stream<asio::ip::tcp::socket>,
 	template<typename> class InQueue = ASCS_INPUT_QUEUE, template<typename> class InContainer = ASCS_INPUT_CONTAINER,
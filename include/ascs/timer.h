@@ -121,6 +121,28 @@ public:
 	DO_SOMETHING_TO_ALL_MUTEX(timer_can, timer_can_mutex)
 	DO_SOMETHING_TO_ONE_MUTEX(timer_can, timer_can_mutex)
 
+#ifdef ASCS_COROUTINE
+	class co_timer
+	{
+	public:
+		co_timer(timer& owner_, unsigned interval) : owner(owner_), t(owner_.io_context_, std::chrono::milliseconds(interval)), result(false) {}
+
+		bool await_ready() const noexcept {return false;}
+		void await_suspend(std::coroutine_handle<> h) {t.async_wait(owner.make_handler_error([this, h](const asio::error_code& ec) {this->result = !ec; h.resume();}));}
+		bool await_resume() const {return result;}
+
+	private:
+		timer& owner;
+		timer_type t;
+		bool result;
+	};
+
+	//co_await async_wait(interval) returns true after interval milliseconds (false if the waiting was aborted), it doesn't occupy any timer id,
+	// so stop_timer and stop_all_timer cannot stop it, the coroutine is resumed in a service thread directly (not in any strand), and this
+	// timer object is tracked (see tracked_executor) until the coroutine been resumed.
+	co_timer async_wait(unsigned interval) {return co_timer(*this, interval);}
+#endif
+
 protected:
 	bool start_timer(timer_info& ti, unsigned interval_ms)
 	{
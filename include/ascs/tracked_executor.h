@@ -46,6 +46,7 @@ public:
 	template<typename F> void dispatch_strand(asio::io_context::strand& strand, F&& handler) {strand.dispatch([ref_holder(this->aci), handler(std::forward<F>(handler))]() {handler();});}
 	#endif
 
+	template<typename F> std::function<void()> make_handler(F&& handler) const {return [ref_holder(this->aci), handler(std::forward<F>(handler))]() {handler();};}
 	template<typename F> handler_with_error make_handler_error(F&& handler) const {return [ref_holder(this->aci), handler(std::forward<F>(handler))](const auto& ec) {handler(ec);};}
 	template<typename F> handler_with_error_size make_handler_error_size(F&& handler) const
 		{return [ref_holder(this->aci), handler(std::forward<F>(handler))](const auto& ec, auto bytes_transferred) {handler(ec, bytes_transferred);};}
@@ -64,6 +65,7 @@ public:
 	template<typename F> void dispatch_strand(asio::io_context::strand& strand, const F& handler) {auto ref_holder(aci); strand.dispatch([=]() {(void) ref_holder; handler();});}
 	#endif
 
+	template<typename F> std::function<void()> make_handler(const F& handler) const {auto ref_holder(aci); return [=]() {(void) ref_holder; handler();};}
 	template<typename F> handler_with_error make_handler_error(const F& handler) const {auto ref_holder(aci); return [=](const asio::error_code& ec) {(void) ref_holder; handler(ec);};}
 	template<typename F> handler_with_error_size make_handler_error_size(const F& handler) const
 		{auto ref_holder(aci); return [=](const asio::error_code& ec, size_t bytes_transferred) {(void) ref_holder; handler(ec, bytes_transferred);};}
@@ -79,6 +79,7 @@ public:
 	{
 		has_bound = false;
 
+		ascs::complete_dropped_item(sending_msg, 0);
 		sending_msg.clear();
 		super::reset();
 	}
@@ -148,10 +149,14 @@ public:
 	// use it any more, use std::move to wrap it when calling direct_send_msg or direct_sync_send_msg.
 	UDP_SEND_MSG(send_msg, false) //use the packer with native = false to pack the msgs
 	UDP_SEND_MSG(send_native_msg, true) //use the packer with native = true to pack the msgs
+	ASCS_CO_SEND_MSG(async_send, send_msg) //co_await async_send(msg), see macro ASCS_COROUTINE
+	ASCS_CO_SEND_MSG(async_send_native, send_native_msg)
 	//guarantee send msg successfully even if can_overflow equal to false
 	//success at here just means put the msg into udp::generic_socket's send buffer
 	UDP_SAFE_SEND_MSG(safe_send_msg, send_msg)
 	UDP_SAFE_SEND_MSG(safe_send_native_msg, send_native_msg)
+	ASCS_CO_SAFE_SEND_MSG(async_safe_send, send_msg) //co_await async_safe_send(msg), see macro ASCS_COROUTINE
+	ASCS_CO_SAFE_SEND_MSG(async_safe_send_native, send_native_msg)
 
 #ifdef ASCS_SYNC_SEND
 	UDP_SYNC_SEND_MSG(sync_send_msg, false) //use the packer with native = false to pack the msgs
@@ -221,7 +226,7 @@ protected:
 	}
 
 #ifdef ASCS_SYNC_SEND
-	virtual void on_close() {if (sending_msg.p) sending_msg.p->set_value(sync_call_result::NOT_APPLICABLE); super::on_close();}
+	virtual void on_close() {sending_msg.complete(sync_call_result::NOT_APPLICABLE); super::on_close();}
 #endif
 
 private:
@@ -293,8 +298,22 @@ private:
 		if (!in_strand && sending)
 			return true;
 
+#ifdef ASCS_MSG_DEADLINE
+		typename super::in_container_type expired_msgs;
+		auto now = std::chrono::steady_clock::now();
+		while (send_buffer.try_dequeue(sending_msg) && this->is_expired(sending_msg, now))
+		{
+			expired_msgs.emplace_back(std::move(sending_msg));
+			sending_msg.clear();
+		}
+		this->expire_msgs(expired_msgs);
+
+		if (!sending_msg.empty())
+#else
 		if (send_buffer.try_dequeue(sending_msg))
+#endif
 		{
+			this->update_mem_usage();
 			sending = true;
 			stat.send_delay_sum += statistic::now() - sending_msg.begin_time;
 			sending_msg.restart();
@@ -309,6 +328,7 @@ private:
 
 	void send_handler(const asio::error_code& ec, size_t bytes_transferred)
 	{
+		auto peak_usage = send_buffer.size_in_byte(); //msgs accumulated during this write
 		if (!ec)
 		{
 			stat.last_send_time = time(nullptr);
@@ -316,9 +336,9 @@ private:
 			stat.send_byte_sum += bytes_transferred;
 			stat.send_time_sum += statistic::now() - sending_msg.begin_time;
 			++stat.send_msg_sum;
+			this->resume_dispatch(); //the sending buffer has more room now, on_msg_handle that failed because of it can succeed
 #ifdef ASCS_SYNC_SEND
-			if (sending_msg.p)
-				sending_msg.p->set_value(sync_call_result::SUCCESS);
+			sending_msg.complete(sync_call_result::SUCCESS);
 #endif
 #ifdef ASCS_WANT_MSG_SEND_NOTIFY
 			this->on_msg_send(sending_msg);
@@ -331,8 +351,7 @@ private:
 		else
 		{
 #ifdef ASCS_SYNC_SEND
-			if (sending_msg.p)
-				sending_msg.p->set_value(sync_call_result::NOT_APPLICABLE);
+			sending_msg.complete(sync_call_result::NOT_APPLICABLE);
 #endif
 			on_send_error(ec, sending_msg);
 		}
@@ -346,6 +365,7 @@ private:
 		//for UDP, sending error will not stop subsequent sending.
 		if (!do_send_msg(true) && !send_buffer.empty())
 			do_send_msg(true); //just make sure no pending msgs
+		this->check_send_buffer(peak_usage);
 	}
 
 private:
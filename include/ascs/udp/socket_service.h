@@ -49,6 +49,14 @@ public:
 		return add_socket(socket_ptr) ? socket_ptr : typename Pool::object_type();
 	}
 
+	///////////////////////////////////////////////////
+	//msg sending interface
+	//pack only once, all sockets share the packed message, see macro UDP_SHARED_BROADCAST_MSG for more details
+	UDP_SHARED_BROADCAST_MSG(shared_broadcast_msg, false)
+	UDP_SHARED_BROADCAST_MSG(shared_broadcast_native_msg, true)
+	//msg sending interface
+	///////////////////////////////////////////////////
+
 	//functions with a socket_ptr parameter will remove the link from object pool first, then call corresponding function
 	void disconnect(typename Pool::object_ctype& socket_ptr) {this->del_object(socket_ptr); socket_ptr->disconnect();}
 	void disconnect() {this->do_something_to_all([](typename Pool::object_ctype& item) {item->disconnect();});}